@@ -0,0 +1,120 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+   A minimal microbenchmark harness in the style of Google Benchmark.
+
+     void BM_thing(bench::State &state) {
+       for (auto _ : state) { ... }
+     }
+     BENCHMARK(BM_thing, 101, 1001);
+
+   Each registered function runs once per argument; the loop body repeats
+   until the minimum run time is reached. Work inside
+   pauseTiming()/resumeTiming() is excluded from the measurement.
+*/
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+class State {
+public:
+  State(int arg, double minSeconds) : _arg(arg), _minSeconds(minSeconds) {}
+
+  /**
+     The argument this run was registered with (usually a maze size).
+  */
+  int arg() const { return _arg; }
+
+  void pauseTiming() { _elapsed += Clock::now() - _start; }
+  void resumeTiming() { _start = Clock::now(); }
+
+  /**
+     Records how many items (cells, pixels, bytes) one iteration processes,
+     so the runner can report throughput.
+  */
+  void setItemsPerIteration(int64_t items) { _itemsPerIteration = items; }
+
+  /**
+     Attaches a free-form label to this run's report line.
+  */
+  void setLabel(std::string label) { _label = std::move(label); }
+
+  size_t iterations() const { return _iterations; }
+  double seconds() const {
+    return std::chrono::duration<double>(_elapsed).count();
+  }
+  int64_t itemsPerIteration() const { return _itemsPerIteration; }
+  const std::string &label() const { return _label; }
+
+  bool keepRunning() {
+    if (_iterations == 0) {
+      _start = Clock::now();
+    } else {
+      pauseTiming();
+      if (seconds() >= _minSeconds)
+        return false;
+      resumeTiming();
+    }
+    ++_iterations;
+    return true;
+  }
+
+  // a non-trivial type so `for (auto _ : state)` is not an unused variable
+  struct Value {
+    ~Value() {}
+  };
+
+  struct Iterator {
+    State *state;
+    bool operator!=(const Iterator &) const { return state->keepRunning(); }
+    void operator++() {}
+    Value operator*() const { return {}; }
+  };
+
+  Iterator begin() { return {this}; }
+  Iterator end() { return {this}; }
+
+private:
+  int _arg;
+  double _minSeconds;
+  size_t _iterations = 0;
+  int64_t _itemsPerIteration = 0;
+  std::string _label;
+  Clock::time_point _start;
+  Clock::duration _elapsed = Clock::duration::zero();
+};
+
+using Function = void (*)(State &);
+
+struct Benchmark {
+  std::string name;
+  Function function;
+  std::vector<int> args;
+};
+
+std::vector<Benchmark> &registry();
+
+int registerBenchmark(const char *name, Function function,
+                      std::vector<int> args);
+
+/**
+   Keeps the compiler from discarding a value whose computation is being
+   measured.
+*/
+template <class T> inline void doNotOptimize(T const &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} // namespace bench
+
+#define BENCHMARK(function, ...)                                              \
+  static const int function##_registered =                                    \
+      ::bench::registerBenchmark(#function, function, {__VA_ARGS__})
+
+#endif
@@ -0,0 +1,57 @@
+#include <string>
+
+#include "../include/ChunkedMaze.h"
+#include "bench.h"
+
+namespace {
+
+const uint64_t SEED = 12345;
+
+// a new chunk every iteration, never cached
+void BM_generateChunk(bench::State &state) {
+  int64_t chunkX = 0;
+  for (auto _ : state) {
+    MazeChunk chunk(SEED, chunkX++, -7, state.arg());
+    bench::doNotOptimize(chunk.grid().data());
+  }
+  state.setItemsPerIteration(int64_t(state.arg()) * state.arg());
+}
+
+/**
+   Sweeps a window of chunks that fits in the cache, so after the first
+   pass every getChunk() is a hit.
+*/
+void BM_getChunkCached(bench::State &state) {
+  ChunkedMaze maze(SEED, state.arg(), 256);
+  int64_t i = 0;
+  for (auto _ : state) {
+    bench::doNotOptimize(maze.getChunk(i % 16, i / 16 % 16));
+    i++;
+  }
+  state.setItemsPerIteration(1);
+  state.setLabel(std::to_string(maze.hits()) + " hits, " +
+                 std::to_string(maze.misses()) + " misses");
+}
+
+/**
+   Walks east through the plane with a cache far smaller than the walk,
+   so chunks are generated and evicted all along; memory stays at the
+   cache capacity.
+*/
+void BM_scanChunks(bench::State &state) {
+  ChunkedMaze maze(SEED, state.arg(), 64);
+  int64_t i = 0;
+  for (auto _ : state) {
+    bench::doNotOptimize(maze.getChunk(i / 4, i % 4));
+    i++;
+  }
+  state.setItemsPerIteration(1);
+  state.setLabel(std::to_string(maze.cachedChunks()) + " cached, " +
+                 std::to_string(maze.misses()) + " generated");
+}
+
+} // namespace
+
+BENCHMARK(BM_generateChunk, 16, 32, 64);
+BENCHMARK(BM_getChunkCached, 32);
+BENCHMARK(BM_scanChunks, 32);
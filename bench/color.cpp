@@ -0,0 +1,157 @@
+#include <vector>
+
+#include "../include/Color_Space.h"
+#include "bench.h"
+
+namespace {
+
+// an arg x arg image of varied sRGB colors, one plane per channel
+struct Planes {
+  std::vector<float> x, y, z;
+
+  explicit Planes(size_t n) : x(n), y(n), z(n) {}
+};
+
+Planes gradient(int size) {
+  Planes rgb(size_t(size) * size);
+  for (size_t i = 0; i < rgb.x.size(); i++) {
+    rgb.x[i] = (i % 256) / 255.f;
+    rgb.y[i] = (i / 256 % 256) / 255.f;
+    rgb.z[i] = (i / 65536 % 256) / 255.f;
+  }
+  return rgb;
+}
+
+void BM_srgbToOkLabScalar(bench::State &state) {
+  const Planes rgb = gradient(state.arg());
+  Planes lab(rgb.x.size());
+  for (auto _ : state) {
+    for (size_t i = 0; i < rgb.x.size(); i++) {
+      auto [l, a, b] =
+          clrspc::Rgb(rgb.x[i], rgb.y[i], rgb.z[i]).to_ok_lab().get_values();
+      lab.x[i] = l;
+      lab.y[i] = a;
+      lab.z[i] = b;
+    }
+    bench::doNotOptimize(lab.x.data());
+  }
+  state.setItemsPerIteration(rgb.x.size());
+}
+
+// the same conversion through the value types, which have no vtable
+void BM_srgbToOkLabValue(bench::State &state) {
+  const Planes rgb = gradient(state.arg());
+  Planes lab(rgb.x.size());
+  for (auto _ : state) {
+    for (size_t i = 0; i < rgb.x.size(); i++) {
+      const clrspc::OkLabf c =
+          clrspc::to_ok_lab(clrspc::Rgbf{rgb.x[i], rgb.y[i], rgb.z[i]});
+      lab.x[i] = c.l;
+      lab.y[i] = c.a;
+      lab.z[i] = c.b;
+    }
+    bench::doNotOptimize(lab.x.data());
+  }
+  state.setItemsPerIteration(rgb.x.size());
+}
+
+// 8-bit input, linearized by table lookup
+void BM_srgb8ToOkLabValue(bench::State &state) {
+  const Planes rgb = gradient(state.arg());
+  std::vector<clrspc::Rgb8> pixels(rgb.x.size());
+  for (size_t i = 0; i < pixels.size(); i++)
+    pixels[i] = clrspc::to_rgb8(clrspc::Rgbf{rgb.x[i], rgb.y[i], rgb.z[i]});
+  std::vector<clrspc::OkLabf> lab(pixels.size());
+  for (auto _ : state) {
+    for (size_t i = 0; i < pixels.size(); i++)
+      lab[i] = clrspc::to_ok_lab(pixels[i]);
+    bench::doNotOptimize(lab.data());
+  }
+  state.setItemsPerIteration(pixels.size());
+}
+
+void BM_srgbToOkLab(bench::State &state) {
+  const Planes rgb = gradient(state.arg());
+  Planes lab(rgb.x.size());
+  for (auto _ : state) {
+    clrspc::srgb_to_ok_lab(rgb.x, rgb.y, rgb.z, lab.x, lab.y, lab.z);
+    bench::doNotOptimize(lab.x.data());
+  }
+  state.setItemsPerIteration(rgb.x.size());
+}
+
+void BM_okLabToSrgbScalar(bench::State &state) {
+  Planes lab = gradient(state.arg());
+  clrspc::srgb_to_ok_lab(lab.x, lab.y, lab.z, lab.x, lab.y, lab.z);
+  Planes rgb(lab.x.size());
+  for (auto _ : state) {
+    for (size_t i = 0; i < lab.x.size(); i++) {
+      auto [r, g, b] =
+          clrspc::Ok_Lab(lab.x[i], lab.y[i], lab.z[i]).to_rgb().get_values();
+      rgb.x[i] = r;
+      rgb.y[i] = g;
+      rgb.z[i] = b;
+    }
+    bench::doNotOptimize(rgb.x.data());
+  }
+  state.setItemsPerIteration(lab.x.size());
+}
+
+void BM_okLabToSrgb(bench::State &state) {
+  Planes lab = gradient(state.arg());
+  clrspc::srgb_to_ok_lab(lab.x, lab.y, lab.z, lab.x, lab.y, lab.z);
+  Planes rgb(lab.x.size());
+  for (auto _ : state) {
+    clrspc::ok_lab_to_srgb(lab.x, lab.y, lab.z, rgb.x, rgb.y, rgb.z);
+    bench::doNotOptimize(rgb.x.data());
+  }
+  state.setItemsPerIteration(lab.x.size());
+}
+
+void BM_okLchAbToOkLab(bench::State &state) {
+  Planes lch(size_t(state.arg()) * state.arg());
+  for (size_t i = 0; i < lch.x.size(); i++) {
+    lch.x[i] = 0.7f;
+    lch.y[i] = 0.18f;
+    lch.z[i] = i * 0.01f;
+  }
+  Planes lab(lch.x.size());
+  for (auto _ : state) {
+    clrspc::ok_lch_ab_to_ok_lab(lch.x, lch.y, lch.z, lab.x, lab.y, lab.z);
+    bench::doNotOptimize(lab.x.data());
+  }
+  state.setItemsPerIteration(lch.x.size());
+}
+
+// linearizes arg x arg 8-bit channels and encodes them back
+template <bool Lut> void BM_srgbRoundTrip(bench::State &state) {
+  std::vector<uint8_t> channels(size_t(state.arg()) * state.arg());
+  for (size_t i = 0; i < channels.size(); i++)
+    channels[i] = uint8_t(i * 7);
+  for (auto _ : state) {
+    for (uint8_t &c : channels) {
+      if (Lut)
+        c = clrspc::linear_to_srgb8(clrspc::srgb8_to_linear(c));
+      else
+        c = uint8_t(std::lround(
+            clrspc::linear_to_srgb(clrspc::srgb_to_linear(c / 255.f)) * 255));
+    }
+    bench::doNotOptimize(channels.data());
+  }
+  state.setItemsPerIteration(channels.size());
+}
+
+auto BM_srgbRoundTripFunction = BM_srgbRoundTrip<false>;
+auto BM_srgbRoundTripLut = BM_srgbRoundTrip<true>;
+
+} // namespace
+
+BENCHMARK(BM_srgbToOkLabScalar, 1001);
+BENCHMARK(BM_srgbToOkLabValue, 1001);
+BENCHMARK(BM_srgb8ToOkLabValue, 1001);
+BENCHMARK(BM_srgbToOkLab, 1001);
+BENCHMARK(BM_okLabToSrgbScalar, 1001);
+BENCHMARK(BM_okLabToSrgb, 1001);
+BENCHMARK(BM_okLchAbToOkLab, 1001);
+BENCHMARK(BM_srgbRoundTripFunction, 1001);
+BENCHMARK(BM_srgbRoundTripLut, 1001);
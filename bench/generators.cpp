@@ -0,0 +1,174 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../include/AldousBroderWilson.h"
+#include "../include/GrowingTree.h"
+#include "../include/HuntAndKill.h"
+#include "../include/maze.h"
+#include "bench.h"
+
+namespace {
+
+const unsigned SEED = 12345;
+
+// number of carvable cells in a size x size pixel maze
+int64_t mazeCells(int size) {
+  const int64_t side = (size - 3) / 2;
+  return side * side;
+}
+
+void prepare(Grid &grid, int size) {
+  grid.assign(size, size, UNVISITED);
+  initializeMaze(grid);
+}
+
+std::string workspaceLabel(size_t bytes) {
+  return "workspace " + std::to_string(bytes / 1024) + " KiB";
+}
+
+/**
+   The reference the growing tree has to match: an iterative backtracker
+   written directly against the packed grid, with the same RNG and the same
+   neighbor selection but no policy abstraction.
+*/
+void handWrittenBacktracker(Grid &grid, int startX, int startY,
+                            std::vector<size_t> &stack, std::mt19937 &rng) {
+  const ptrdiff_t stride = grid.stride();
+  const ptrdiff_t offsets[4] = {-2 * stride, 2 * stride, -2, 2};
+  cellState *cells = grid.data();
+
+  stack.clear();
+  stack.push_back(grid.index(startX, startY));
+  cells[stack.back()] = VISITED;
+
+  while (!stack.empty()) {
+    const ptrdiff_t curr = stack.back();
+
+    ptrdiff_t options[4];
+    uint32_t optionCount = 0;
+    for (ptrdiff_t offset : offsets) {
+      options[optionCount] = offset;
+      optionCount += cells[curr + offset] != VISITED;
+    }
+
+    if (optionCount == 0) {
+      stack.pop_back();
+      continue;
+    }
+
+    const ptrdiff_t offset =
+        options[optionCount == 1 ? 0 : boundedRandom(rng, optionCount)];
+    cells[curr + offset / 2] = VISITED;
+    cells[curr + offset] = VISITED;
+    stack.push_back(curr + offset);
+  }
+}
+
+void BM_generateNewMazeCellStack(bench::State &state) {
+  Grid grid;
+  std::srand(SEED);
+  for (auto _ : state) {
+    state.pauseTiming();
+    prepare(grid, state.arg());
+    state.resumeTiming();
+    generateNewMazeCellStack(2, 2, grid);
+  }
+  state.setItemsPerIteration(mazeCells(state.arg()));
+}
+
+// recurses once per cell on the path, so larger sizes overflow the stack
+void BM_generateNewMazeCellRecursive(bench::State &state) {
+  Grid grid;
+  std::srand(SEED);
+  for (auto _ : state) {
+    state.pauseTiming();
+    prepare(grid, state.arg());
+    state.resumeTiming();
+    generateNewMazeCellRecursive(2, 2, grid);
+  }
+  state.setItemsPerIteration(mazeCells(state.arg()));
+}
+
+void BM_handWrittenBacktracker(bench::State &state) {
+  Grid grid;
+  std::vector<size_t> stack;
+  std::mt19937 rng(SEED);
+  for (auto _ : state) {
+    state.pauseTiming();
+    prepare(grid, state.arg());
+    state.resumeTiming();
+    handWrittenBacktracker(grid, 2, 2, stack, rng);
+  }
+  state.setItemsPerIteration(mazeCells(state.arg()));
+  state.setLabel(workspaceLabel(stack.capacity() * sizeof(size_t)));
+}
+
+template <class Policy> void BM_growingTree(bench::State &state) {
+  Grid grid;
+  GrowingTree<Policy> generator{std::mt19937(SEED)};
+  for (auto _ : state) {
+    state.pauseTiming();
+    prepare(grid, state.arg());
+    state.resumeTiming();
+    generator.generate(grid, 2, 2);
+  }
+  state.setItemsPerIteration(mazeCells(state.arg()));
+  state.setLabel(workspaceLabel(generator.workspaceBytes()));
+}
+
+void BM_huntAndKill(bench::State &state) {
+  Grid grid;
+  HuntAndKill<> generator{std::mt19937(SEED)};
+  for (auto _ : state) {
+    state.pauseTiming();
+    prepare(grid, state.arg());
+    state.resumeTiming();
+    generator.generate(grid, 2, 2);
+  }
+  state.setItemsPerIteration(mazeCells(state.arg()));
+  state.setLabel(workspaceLabel(generator.workspaceBytes()));
+}
+
+template <unsigned SwitchPercent>
+void BM_aldousBroderWilson(bench::State &state) {
+  Grid grid;
+  AldousBroderWilson<> generator{std::mt19937(SEED), SwitchPercent / 100.0};
+  for (auto _ : state) {
+    state.pauseTiming();
+    prepare(grid, state.arg());
+    state.resumeTiming();
+    generator.generate(grid, 2, 2);
+  }
+  state.setItemsPerIteration(mazeCells(state.arg()));
+}
+
+auto BM_growingTreeNewest = BM_growingTree<NewestCell>;
+auto BM_growingTreeRandom = BM_growingTree<RandomCell>;
+auto BM_growingTreeMixed50 = BM_growingTree<MixedCell<50>>;
+auto BM_growingTreeMixed90 = BM_growingTree<MixedCell<90>>;
+auto BM_wilson = BM_aldousBroderWilson<0>;
+auto BM_aldousBroderWilson10 = BM_aldousBroderWilson<10>;
+auto BM_aldousBroderWilson25 = BM_aldousBroderWilson<25>;
+auto BM_aldousBroderWilson50 = BM_aldousBroderWilson<50>;
+auto BM_aldousBroderWilson75 = BM_aldousBroderWilson<75>;
+auto BM_aldousBroderWilson90 = BM_aldousBroderWilson<90>;
+auto BM_aldousBroder = BM_aldousBroderWilson<100>;
+
+} // namespace
+
+BENCHMARK(BM_generateNewMazeCellStack, 101, 1001, 4001);
+BENCHMARK(BM_generateNewMazeCellRecursive, 101, 501);
+BENCHMARK(BM_handWrittenBacktracker, 101, 1001, 4001);
+BENCHMARK(BM_growingTreeNewest, 101, 1001, 4001);
+BENCHMARK(BM_growingTreeRandom, 101, 1001, 4001);
+BENCHMARK(BM_growingTreeMixed50, 101, 1001, 4001);
+BENCHMARK(BM_growingTreeMixed90, 101, 1001, 4001);
+BENCHMARK(BM_huntAndKill, 101, 1001, 4001);
+BENCHMARK(BM_wilson, 101, 501, 1001);
+BENCHMARK(BM_aldousBroderWilson10, 101, 501, 1001);
+BENCHMARK(BM_aldousBroderWilson25, 101, 501, 1001);
+BENCHMARK(BM_aldousBroderWilson50, 101, 501, 1001);
+BENCHMARK(BM_aldousBroderWilson75, 101, 501, 1001);
+BENCHMARK(BM_aldousBroderWilson90, 101, 501, 1001);
+BENCHMARK(BM_aldousBroder, 101, 501, 1001);
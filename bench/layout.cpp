@@ -0,0 +1,80 @@
+#include <random>
+#include <string>
+
+#include "../include/GrowingTree.h"
+#include "../include/PerfCounters.h"
+#include "../include/maze.h"
+#include "bench.h"
+
+namespace {
+
+const unsigned SEED = 12345;
+
+int64_t mazeCells(int size) {
+  const int64_t side = (size - 3) / 2;
+  return side * side;
+}
+
+/**
+   Runs the backtracker on a size x size maze stored in the given layout.
+   Each iteration copies a freshly initialized row-major grid into the
+   layout outside the timed region, so every layout carves the same maze.
+   The label gives the size of the cell buffer, padding included, and the
+   cache and dTLB misses per maze cell of the carving alone, where the CPU
+   exposes them.
+*/
+template <class Layout> void BM_backtrackerLayout(bench::State &state) {
+  Grid initial(state.arg(), state.arg());
+  initializeMaze(initial);
+  BasicGrid<Layout> grid;
+  Backtracker generator{std::mt19937(SEED)};
+
+  PerfCounters counters;
+  counters.open();
+  PerfCounters::Counts misses{};
+  int64_t iterations = 0;
+  for (auto _ : state) {
+    state.pauseTiming();
+    copyGrid(initial, grid);
+    const PerfCounters::Counts before = counters.read();
+    state.resumeTiming();
+    generator.generate(grid, 2, 2);
+    state.pauseTiming();
+    const PerfCounters::Counts after = counters.read();
+    for (int event = 0; event < PerfCounters::EVENTS; event++)
+      misses[event] += after[event] - before[event];
+    iterations++;
+    state.resumeTiming();
+  }
+  bench::doNotOptimize(grid.data());
+
+  const int64_t cells = mazeCells(state.arg());
+  state.setItemsPerIteration(cells);
+  std::string label =
+      "buffer " + std::to_string(grid.size() / 1024) + " KiB";
+  if (counters.hasEvent(PerfCounters::CACHE_MISSES)) {
+    const double total = double(cells) * iterations;
+    label += ", " +
+             std::to_string(misses[PerfCounters::CACHE_MISSES] / total) +
+             " cache-misses/cell";
+    if (counters.hasEvent(PerfCounters::DTLB_MISSES))
+      label += ", " +
+               std::to_string(misses[PerfCounters::DTLB_MISSES] / total) +
+               " dTLB-misses/cell";
+  } else {
+    label += ", no miss counters";
+  }
+  state.setLabel(label);
+}
+
+auto BM_backtrackerRowMajor = BM_backtrackerLayout<RowMajor>;
+auto BM_backtrackerTiled16 = BM_backtrackerLayout<Tiled<16>>;
+auto BM_backtrackerTiled64 = BM_backtrackerLayout<Tiled<64>>;
+auto BM_backtrackerZOrder = BM_backtrackerLayout<ZOrder>;
+
+} // namespace
+
+BENCHMARK(BM_backtrackerRowMajor, 1001, 4001, 10001);
+BENCHMARK(BM_backtrackerTiled16, 1001, 4001, 10001);
+BENCHMARK(BM_backtrackerTiled64, 1001, 4001, 10001);
+BENCHMARK(BM_backtrackerZOrder, 1001, 4001, 10001);
@@ -0,0 +1,230 @@
+#include <vector>
+
+#include "../include/generator.h"
+#include "../include/lodepng.h"
+#include "../include/maze.h"
+#include "../include/mazefile.h"
+#include "../include/picture.h"
+#include "bench.h"
+
+namespace {
+
+const unsigned SEED = 12345;
+
+int64_t pixels(int size) { return int64_t(size) * size; }
+
+// a generated (and optionally solved) size x size maze, the same every run
+void makeMaze(Grid &grid, int size, bool solve) {
+  MazeGenerator generator(Algorithm::BACKTRACKER);
+  generator.seed(SEED);
+  grid.assign(size, size, UNVISITED);
+  initializeMaze(grid);
+  generator.generate(grid, 2, 2);
+  if (solve)
+    solveMaze(grid);
+}
+
+// the RGBA bytes lodepng encodes, read back through the public accessors
+std::vector<unsigned char> rgba(const Picture &pic) {
+  std::vector<unsigned char> values;
+  values.reserve(4 * size_t(pic.width()) * pic.height());
+  for (int y = 0; y < pic.height(); y++) {
+    for (int x = 0; x < pic.width(); x++) {
+      values.push_back(pic.red(x, y));
+      values.push_back(pic.green(x, y));
+      values.push_back(pic.blue(x, y));
+      values.push_back(255);
+    }
+  }
+  return values;
+}
+
+void BM_initializeMaze(bench::State &state) {
+  Grid grid(state.arg(), state.arg(), UNVISITED);
+  for (auto _ : state) {
+    initializeMaze(grid);
+    bench::doNotOptimize(grid.data());
+  }
+  state.setItemsPerIteration(pixels(state.arg()));
+}
+
+void BM_solveMaze(bench::State &state) {
+  Grid maze, grid;
+  makeMaze(maze, state.arg(), false);
+  std::vector<std::pair<int, int>> stack;
+  for (auto _ : state) {
+    state.pauseTiming();
+    grid = maze;
+    state.resumeTiming();
+    solveMaze(grid, stack);
+  }
+  state.setItemsPerIteration(pixels(state.arg()));
+}
+
+void BM_renderMaze(bench::State &state) {
+  Grid grid;
+  makeMaze(grid, state.arg(), true);
+  Picture pic;
+  for (auto _ : state) {
+    renderMaze(grid, pic, 1);
+  }
+  state.setItemsPerIteration(pixels(state.arg()));
+}
+
+// the palette is built once, outside the loop, as the program does
+void BM_renderMazeDistance(bench::State &state) {
+  Grid grid;
+  makeMaze(grid, state.arg(), true);
+  const std::vector<clrspc::Rgb8> palette = distancePalette();
+  Picture pic;
+  for (auto _ : state) {
+    renderMazeDistance(grid, pic, 1, palette);
+  }
+  state.setItemsPerIteration(pixels(state.arg()));
+}
+
+// renders and writes maze.png to the working directory
+void BM_createPicture(bench::State &state) {
+  Grid grid;
+  makeMaze(grid, state.arg(), true);
+  for (auto _ : state) {
+    createPicture(grid);
+  }
+  state.setItemsPerIteration(pixels(state.arg()));
+}
+
+void BM_bilinearResize(bench::State &state) {
+  Grid grid;
+  makeMaze(grid, state.arg(), true);
+  Picture pic;
+  renderMaze(grid, pic, 1);
+  for (auto _ : state) {
+    Picture resized = pic.bilinearResize(2.5f);
+    bench::doNotOptimize(resized);
+  }
+  state.setItemsPerIteration(pixels(state.arg()) * 25 / 4);
+}
+
+// the 8x print upscale, in output pixels per second
+void BM_scaleNearest(bench::State &state) {
+  Grid grid;
+  makeMaze(grid, state.arg(), true);
+  Picture pic;
+  renderMaze(grid, pic, 1);
+  for (auto _ : state) {
+    Picture scaled = pic.scaleNearest(8);
+    bench::doNotOptimize(scaled);
+  }
+  state.setItemsPerIteration(pixels(state.arg()) * 64);
+  state.setLabel(std::to_string(pixels(state.arg()) * 64 * 4 / 1000000) +
+                 " MB out");
+}
+
+// writes maze.maze to the working directory
+void BM_writeMazeFile(bench::State &state) {
+  Grid grid;
+  makeMaze(grid, state.arg(), false);
+  for (auto _ : state) {
+    writeMazeFile("maze.maze", grid, SEED, Algorithm::BACKTRACKER);
+  }
+  state.setItemsPerIteration(pixels(state.arg()));
+}
+
+// maps the file and reads one cell, which costs the same for any size
+void BM_openMazeFile(bench::State &state) {
+  Grid grid;
+  makeMaze(grid, state.arg(), false);
+  writeMazeFile("maze.maze", grid, SEED, Algorithm::BACKTRACKER);
+  for (auto _ : state) {
+    const MazeFile file("maze.maze");
+    bench::doNotOptimize(file.view().at(state.arg() / 2, state.arg() / 2));
+  }
+  state.setItemsPerIteration(pixels(state.arg()));
+}
+
+// unpacks a whole mapped file into a grid, the counterpart of a PNG decode
+void BM_loadMazeFile(bench::State &state) {
+  Grid grid;
+  makeMaze(grid, state.arg(), false);
+  writeMazeFile("maze.maze", grid, SEED, Algorithm::BACKTRACKER);
+  const MazeFile file("maze.maze");
+  for (auto _ : state) {
+    file.view().toGrid(grid);
+  }
+  state.setItemsPerIteration(pixels(state.arg()));
+}
+
+void BM_lodepngEncode(bench::State &state) {
+  Grid grid;
+  makeMaze(grid, state.arg(), true);
+  Picture pic;
+  renderMaze(grid, pic, 1);
+  const std::vector<unsigned char> image = rgba(pic);
+  std::vector<unsigned char> png;
+  for (auto _ : state) {
+    png.clear();
+    lodepng::encode(png, image, pic.width(), pic.height());
+  }
+  state.setItemsPerIteration(pixels(state.arg()));
+  state.setLabel(std::to_string(png.size() / 1024) + " KiB png");
+}
+
+// Picture::encode into a reused vector, one copy out of the encoder
+void BM_encodeToVector(bench::State &state) {
+  Grid grid;
+  makeMaze(grid, state.arg(), true);
+  Picture pic;
+  renderMaze(grid, pic, 1);
+  std::vector<unsigned char> png;
+  for (auto _ : state) {
+    pic.encode(png);
+    bench::doNotOptimize(png.data());
+  }
+  state.setItemsPerIteration(pixels(state.arg()));
+}
+
+// Picture::encode returning the encoder's own buffer
+void BM_encodeToPngData(bench::State &state) {
+  Grid grid;
+  makeMaze(grid, state.arg(), true);
+  Picture pic;
+  renderMaze(grid, pic, 1);
+  for (auto _ : state) {
+    const PngData png = pic.encode();
+    bench::doNotOptimize(png.data());
+  }
+  state.setItemsPerIteration(pixels(state.arg()));
+}
+
+void BM_lodepngDecode(bench::State &state) {
+  Grid grid;
+  makeMaze(grid, state.arg(), true);
+  Picture pic;
+  renderMaze(grid, pic, 1);
+  std::vector<unsigned char> png;
+  lodepng::encode(png, rgba(pic), pic.width(), pic.height());
+  std::vector<unsigned char> image;
+  unsigned width, height;
+  for (auto _ : state) {
+    image.clear();
+    lodepng::decode(image, width, height, png);
+  }
+  state.setItemsPerIteration(pixels(state.arg()));
+}
+
+} // namespace
+
+BENCHMARK(BM_initializeMaze, 101, 501, 1001, 2001, 4001);
+BENCHMARK(BM_solveMaze, 101, 501, 1001, 2001, 4001);
+BENCHMARK(BM_renderMaze, 101, 501, 1001, 2001, 4001);
+BENCHMARK(BM_renderMazeDistance, 101, 501, 1001, 2001, 4001, 10001);
+BENCHMARK(BM_createPicture, 101, 501, 1001, 2001);
+BENCHMARK(BM_bilinearResize, 101, 501, 1001);
+BENCHMARK(BM_scaleNearest, 101, 501, 1001, 2001);
+BENCHMARK(BM_writeMazeFile, 1001, 4001, 10001);
+BENCHMARK(BM_openMazeFile, 1001, 4001, 10001);
+BENCHMARK(BM_loadMazeFile, 1001, 4001, 10001);
+BENCHMARK(BM_lodepngEncode, 101, 501, 1001, 2001);
+BENCHMARK(BM_encodeToVector, 101, 501, 1001, 2001);
+BENCHMARK(BM_encodeToPngData, 101, 501, 1001, 2001);
+BENCHMARK(BM_lodepngDecode, 101, 501, 1001, 2001);
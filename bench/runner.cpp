@@ -0,0 +1,139 @@
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "bench.h"
+
+namespace bench {
+
+std::vector<Benchmark> &registry() {
+  static std::vector<Benchmark> benchmarks;
+  return benchmarks;
+}
+
+int registerBenchmark(const char *name, Function function,
+                      std::vector<int> args) {
+  registry().push_back({name, function, std::move(args)});
+  return 0;
+}
+
+} // namespace bench
+
+namespace {
+
+struct Result {
+  std::string name;
+  size_t iterations;
+  double secondsPerIteration;
+  double itemsPerSecond;
+  std::string label;
+};
+
+std::string jsonString(const std::string &text) {
+  std::string quoted = "\"";
+  for (char c : text) {
+    if (c == '"' || c == '\\')
+      quoted += '\\';
+    quoted += c;
+  }
+  return quoted + '"';
+}
+
+/**
+   Writes the results in the JSON layout of Google Benchmark's
+   --benchmark_out, so its compare.py and other tooling can diff two runs.
+*/
+void writeJson(std::ostream &out, const std::vector<Result> &results,
+               const char *executable) {
+  char date[32];
+  const std::time_t now = std::time(nullptr);
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+  out << "{\n  \"context\": {\n"
+      << "    \"date\": " << jsonString(date) << ",\n"
+      << "    \"executable\": " << jsonString(executable) << ",\n"
+      << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+#ifdef NDEBUG
+      << "    \"library_build_type\": \"release\"\n"
+#else
+      << "    \"library_build_type\": \"debug\"\n"
+#endif
+      << "  },\n  \"benchmarks\": [";
+
+  const char *separator = "\n";
+  for (const Result &result : results) {
+    out << separator << "    {\n"
+        << "      \"name\": " << jsonString(result.name) << ",\n"
+        << "      \"run_name\": " << jsonString(result.name) << ",\n"
+        << "      \"run_type\": \"iteration\",\n"
+        << "      \"iterations\": " << result.iterations << ",\n"
+        << std::setprecision(9) << std::defaultfloat
+        << "      \"real_time\": " << result.secondsPerIteration * 1e9 << ",\n"
+        << "      \"cpu_time\": " << result.secondsPerIteration * 1e9 << ",\n"
+        << "      \"time_unit\": \"ns\"";
+    if (result.itemsPerSecond > 0)
+      out << ",\n      \"items_per_second\": " << result.itemsPerSecond;
+    if (!result.label.empty())
+      out << ",\n      \"label\": " << jsonString(result.label);
+    out << "\n    }";
+    separator = ",\n";
+  }
+  out << "\n  ]\n}\n";
+}
+
+} // namespace
+
+// usage: bench [--json FILE] [name filter]
+int main(int argc, char *argv[]) {
+  const char *filter = "";
+  const char *jsonPath = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+      jsonPath = argv[++i];
+    else
+      filter = argv[i];
+  }
+  const double minSeconds = 0.5;
+
+  std::cout << std::left << std::setw(40) << "benchmark" << std::right
+            << std::setw(14) << "ms/iter" << std::setw(10) << "iters"
+            << std::setw(16) << "Mitems/s" << '\n';
+
+  std::vector<Result> results;
+  for (const auto &benchmark : bench::registry()) {
+    if (!std::strstr(benchmark.name.c_str(), filter))
+      continue;
+
+    for (int arg : benchmark.args) {
+      bench::State state(arg, minSeconds);
+      benchmark.function(state);
+
+      const double perIteration = state.seconds() / state.iterations();
+      const std::string name = benchmark.name + "/" + std::to_string(arg);
+      results.push_back({name, state.iterations(), perIteration,
+                         state.itemsPerIteration() / perIteration,
+                         state.label()});
+
+      std::cout << std::left << std::setw(40) << name << std::right
+                << std::fixed << std::setprecision(3) << std::setw(14)
+                << perIteration * 1e3 << std::setw(10) << state.iterations()
+                << std::setw(16) << std::setprecision(2)
+                << state.itemsPerIteration() / perIteration / 1e6;
+      if (!state.label().empty())
+        std::cout << "  " << state.label();
+      std::cout << std::endl;
+    }
+  }
+
+  if (jsonPath) {
+    std::ofstream out(jsonPath);
+    if (!out) {
+      std::cerr << "Could not write " << jsonPath << std::endl;
+      return 1;
+    }
+    writeJson(out, results, argv[0]);
+  }
+}
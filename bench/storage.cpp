@@ -0,0 +1,60 @@
+#include <string>
+
+#include <sys/resource.h>
+
+#include "../include/generator.h"
+#include "../include/maze.h"
+#include "bench.h"
+
+namespace {
+
+const unsigned SEED = 12345;
+
+// minor (no I/O) and major (read from disk) page faults of this process
+struct Faults {
+  long minor;
+  long major;
+};
+
+Faults pageFaults() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return {usage.ru_minflt, usage.ru_majflt};
+}
+
+/**
+   Initializes, generates and solves a size x size maze on a grid in the
+   given storage; the grid is rebuilt every iteration, so a mapped grid
+   maps and faults in a fresh file each time, as a one-off run does. The
+   label gives the page faults per million grid cells.
+*/
+template <GridStorage Storage> void BM_mazeOnGrid(bench::State &state) {
+  MazeGenerator generator(Algorithm::BACKTRACKER);
+  std::vector<std::pair<int, int>> stack;
+  const Faults before = pageFaults();
+  int64_t iterations = 0;
+  for (auto _ : state) {
+    Grid grid(state.arg(), state.arg(), UNVISITED, Storage);
+    initializeMaze(grid);
+    generator.seed(SEED);
+    generator.generate(grid, 2, 2);
+    solveMaze(grid, stack);
+    bench::doNotOptimize(grid.data());
+    iterations++;
+  }
+  const Faults after = pageFaults();
+  const double cells = double(state.arg()) * state.arg() * iterations / 1e6;
+  state.setItemsPerIteration(int64_t(state.arg()) * state.arg());
+  state.setLabel(std::to_string(int((after.minor - before.minor) / cells)) +
+                 " minor + " +
+                 std::to_string(int((after.major - before.major) / cells)) +
+                 " major faults/Mcell");
+}
+
+auto BM_mazeOnMemoryGrid = BM_mazeOnGrid<GridStorage::MEMORY>;
+auto BM_mazeOnMappedGrid = BM_mazeOnGrid<GridStorage::MAPPED>;
+
+} // namespace
+
+BENCHMARK(BM_mazeOnMemoryGrid, 1001, 4001, 10001);
+BENCHMARK(BM_mazeOnMappedGrid, 1001, 4001, 10001);
@@ -0,0 +1,60 @@
+#include <string>
+
+#include "../include/generator.h"
+#include "../include/maze.h"
+#include "../include/picture.h"
+#include "../include/tilepyramid.h"
+#include "bench.h"
+
+namespace {
+
+const unsigned SEED = 12345;
+
+void prepareSolved(Grid &grid, int size) {
+  grid.assign(size, size, UNVISITED);
+  initializeMaze(grid);
+  MazeGenerator generator(Algorithm::BACKTRACKER);
+  generator.seed(SEED);
+  generator.generate(grid, 2, 2);
+  solveMaze(grid);
+}
+
+/**
+   Renders and encodes the whole pyramid of a solved maze into memory.
+   Items are full-resolution pixels. The label gives the tile count and
+   their PNG size.
+*/
+void BM_tilePyramid(bench::State &state) {
+  Grid grid;
+  prepareSolved(grid, state.arg());
+  TilePyramidStats stats;
+  for (auto _ : state) {
+    stats = renderTilePyramid(
+        grid, TilePyramidOptions(),
+        [](int, int, int, std::span<const unsigned char> png) {
+          bench::doNotOptimize(png.data());
+        });
+  }
+  state.setItemsPerIteration(int64_t(state.arg()) * state.arg());
+  state.setLabel(std::to_string(stats.tiles) + " tiles, " +
+                 std::to_string(stats.bytes >> 10) + " KiB");
+}
+
+// the single image the pyramid replaces, for comparison
+void BM_renderAndEncodeWhole(bench::State &state) {
+  Grid grid;
+  prepareSolved(grid, state.arg());
+  Picture picture;
+  std::vector<unsigned char> png;
+  for (auto _ : state) {
+    renderMaze(grid, picture, 1);
+    picture.encode(png);
+  }
+  state.setItemsPerIteration(int64_t(state.arg()) * state.arg());
+  state.setLabel(std::to_string(png.size() >> 10) + " KiB");
+}
+
+} // namespace
+
+BENCHMARK(BM_tilePyramid, 1001, 4001);
+BENCHMARK(BM_renderAndEncodeWhole, 1001, 4001);
@@ -0,0 +1,46 @@
+#include "../include/Timer.h"
+#include "bench.h"
+
+namespace {
+
+const int SCOPES_PER_ITERATION = 1 << 20;
+
+// the two clock reads alone, the part of a scope the budget leaves out
+void BM_timerClock(bench::State &state) {
+  for (auto _ : state) {
+    for (int i = 0; i < SCOPES_PER_ITERATION; i++) {
+      const uint64_t start = Timer::readTicks();
+      bench::doNotOptimize(i);
+      bench::doNotOptimize(Timer::readTicks() - start);
+    }
+  }
+  state.setItemsPerIteration(SCOPES_PER_ITERATION);
+}
+
+// cost of one empty TIMER_ZONE scope, including the clock reads
+void BM_timerZone(bench::State &state) {
+  for (auto _ : state) {
+    for (int i = 0; i < SCOPES_PER_ITERATION; i++) {
+      TIMER_ZONE("BM_timerZone");
+      bench::doNotOptimize(i);
+    }
+  }
+  state.setItemsPerIteration(SCOPES_PER_ITERATION);
+}
+
+// the same scope looked up by name on every call
+void BM_timerByName(bench::State &state) {
+  for (auto _ : state) {
+    for (int i = 0; i < SCOPES_PER_ITERATION; i++) {
+      Timer timer("BM_timerByName");
+      bench::doNotOptimize(i);
+    }
+  }
+  state.setItemsPerIteration(SCOPES_PER_ITERATION);
+}
+
+} // namespace
+
+BENCHMARK(BM_timerClock, 0);
+BENCHMARK(BM_timerZone, 0);
+BENCHMARK(BM_timerByName, 0);
@@ -0,0 +1,130 @@
+#ifndef CHUNKEDMAZE_H
+#define CHUNKEDMAZE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "Grid.h"
+
+/**
+   One square chunk of a ChunkedMaze: chunkCells x chunkCells maze cells
+   and the walls around them, 2 * chunkCells + 1 pixels on a side. Pixel
+   (0, 0) is the north-west wall corner; cells are at odd local
+   coordinates. The wall lines on the chunk's edges are shared with its
+   neighbors, which agree on every pixel of them.
+*/
+class MazeChunk {
+public:
+  /**
+     Generates chunk (chunkX, chunkY) of the maze with the given seed.
+     Depends on nothing else, so any chunk comes out the same on every
+     call, thread and machine.
+     @throws std::invalid_argument if chunkCells is less than 1
+  */
+  MazeChunk(uint64_t seed, int64_t chunkX, int64_t chunkY, int chunkCells);
+
+  int64_t chunkX() const { return _chunkX; }
+  int64_t chunkY() const { return _chunkY; }
+
+  // pixels along each side, the shared edges included
+  int side() const { return _grid.width() - 2; }
+
+  /**
+     Yields the state of a local pixel: VISITED where open, UNVISITED for
+     walls.
+     @throws std::out_of_range if the point is not in the chunk
+  */
+  cellState at(int x, int y) const {
+    if (x < 0 || x >= side() || y < 0 || y >= side())
+      throw std::out_of_range("Chunk position out of range.");
+    return _grid[_grid.index(x + 1, y + 1)];
+  }
+
+  /**
+     The generated grid, with the sentinel border of initializeMaze
+     around the chunk: local pixel (x, y) is grid cell (x + 1, y + 1).
+  */
+  const Grid &grid() const { return _grid; }
+
+  size_t bytes() const { return sizeof(*this) + _grid.size(); }
+
+private:
+  int64_t _chunkX;
+  int64_t _chunkY;
+  Grid _grid;
+};
+
+/**
+   A maze without bounds, made of independently generated chunks.
+
+   Each chunk is a perfect maze carved by the backtracker from a
+   counter-based RNG keyed on (seed, chunkX, chunkY). Every edge two
+   chunks share has exactly one opening. Its position is a hash of the
+   seed and the edge, so both chunks compute the same one. Every chunk is
+   connected inside and to its four neighbors, so the whole plane is
+   connected. There are loops at chunk scale, so it is not a perfect maze.
+
+   Recently used chunks are kept in an LRU cache of fixed capacity. The
+   memory used is capacity times the chunk size, however much of the plane
+   has been visited. All members are safe to call from several threads.
+*/
+class ChunkedMaze {
+public:
+  /**
+     @param seed the maze
+     @param chunkCells maze cells along each side of a chunk
+     @param cacheChunks the most chunks kept in memory
+     @throws std::invalid_argument if chunkCells or cacheChunks is less
+     than 1
+  */
+  explicit ChunkedMaze(uint64_t seed, int chunkCells = 32,
+                       size_t cacheChunks = 1024);
+
+  uint64_t seed() const { return _seed; }
+  int chunkCells() const { return _chunkCells; }
+
+  // distance in pixels between the origins of neighboring chunks
+  int64_t chunkPitch() const { return 2 * int64_t(_chunkCells); }
+
+  /**
+     Returns a chunk from the cache or generates and caches it. The chunk
+     stays valid as long as it is held, even after the cache evicts it.
+  */
+  std::shared_ptr<const MazeChunk> getChunk(int64_t chunkX, int64_t chunkY);
+
+  /**
+     Yields the state of a pixel of the plane. Chunk (cx, cy) covers
+     pixels from (cx, cy) * chunkPitch() through the next chunk's origin.
+  */
+  cellState at(int64_t x, int64_t y);
+
+  size_t cachedChunks() const;
+  uint64_t hits() const;
+  uint64_t misses() const;
+
+private:
+  using Key = std::pair<int64_t, int64_t>;
+
+  struct KeyHash {
+    size_t operator()(const Key &key) const;
+  };
+
+  using LruList = std::list<std::shared_ptr<const MazeChunk>>;
+
+  uint64_t _seed;
+  int _chunkCells;
+  size_t _capacity;
+
+  mutable std::mutex _mutex;
+  LruList _lru; // most recently used first
+  std::unordered_map<Key, LruList::iterator, KeyHash> _index;
+  uint64_t _hits = 0;
+  uint64_t _misses = 0;
+};
+
+#endif
@@ -3,12 +3,22 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <initializer_list>
 #include <iostream>
+#include <span>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define CLRSPC_AVX2 1
+#endif
+
 #define _USE_MATH_DEFINES // for VS
 
+#include "Color_Types.h"
+
 typedef std::array<u_int8_t, 3> Tristimulus;
 
 namespace clrspc {
@@ -93,6 +103,22 @@ inline float normalize_degrees(float x) {
   return x - std::floor(x / 360.0f) * 360.0f;
 }
 
+// sRGB transfer curve, gamma-encoded [0, 1] to linear light
+inline float srgb_to_linear(float c) {
+  c = std::fmax(0.f, c); // normalize and avoid negatives
+  return (c <= 0.04045f)
+             ? c / 12.92f
+             : std::exp2f(std::log2f((c + 0.055f) / 1.055f) * 2.4f);
+}
+
+// inverse sRGB transfer curve, linear light to gamma-encoded [0, 1]
+inline float linear_to_srgb(float c) {
+  c = std::fmax(0.f, c);
+  return (c <= 0.0031308f)
+             ? 12.92f * c
+             : 1.055f * std::exp2f(std::log2f(c) * 0.41666f) - 0.055f;
+}
+
 inline std::array<float, 3>
 cartesian_to_polar(std::array<float, 3> const &cartesian_color_space) {
   auto [l, a, b] = cartesian_color_space;
@@ -114,43 +140,80 @@ polar_to_cartesian(std::array<float, 3> const &polar_color_space) {
   return {l, a, b};
 }
 
-// =========== okOK_LAB Space ==========
+// =========== Value conversions ==========
+//
+// The conversions behind the Color classes, on the value types of
+// Color_Types.h. They inline into a caller's loop; the classes below call
+// them too, so both give the same numbers.
 
-inline Ok_Lab::Ok_Lab(float l, float a, float b) : Color(l, a, b) {}
-
-inline Ok_Lch_Ab Ok_Lab::to_ok_lch_ab() const {
-  auto [l, c, h] = cartesian_to_polar(m_values);
+inline OkLchf to_ok_lch(OkLabf c) {
+  auto [l, ch, h] = cartesian_to_polar({c.l, c.a, c.b});
+  return {l, ch, h};
+}
 
-  return Ok_Lch_Ab(l, c, h);
+inline OkLabf to_ok_lab(OkLchf c) {
+  auto [l, a, b] = polar_to_cartesian({c.l, c.c, c.h});
+  return {l, a, b};
 }
 
-inline Rgb Ok_Lab::to_rgb() const
+// linear-light sRGB to OKLab
+inline OkLabf linear_to_ok_lab(float r, float g, float b) {
+  float l = 0.4122214708f * r + 0.5363325363f * g + 0.0514459929f * b;
+  float m = 0.2119034982f * r + 0.6806995451f * g + 0.1073969566f * b;
+  float s = 0.0883024619f * r + 0.2817188376f * g + 0.6299787005f * b;
+
+  float l_ = cbrtf(l);
+  float m_ = cbrtf(m);
+  float s_ = cbrtf(s);
 
-{
-  auto gamma = [](float c) {
-    c = std::fmax(0.f, c);
-    float encoded =
-        (c <= 0.0031308f)
-            ? 12.92f * c
-            : 1.055f * std::exp2f(std::log2f(c) * 0.41666f) - 0.055f;
-    return encoded;
+  return {
+      0.2104542553f * l_ + 0.7936177850f * m_ - 0.0040720468f * s_,
+      1.9779984951f * l_ - 2.4285922050f * m_ + 0.4505937099f * s_,
+      0.0259040371f * l_ + 0.7827717662f * m_ - 0.8086757660f * s_,
   };
+}
 
-  auto [L, a, b] = m_values;
+inline OkLabf to_ok_lab(Rgbf c) {
+  return linear_to_ok_lab(srgb_to_linear(c.r), srgb_to_linear(c.g),
+                          srgb_to_linear(c.b));
+}
 
-  float l_ = L + 0.3963377774f * a + 0.2158037573f * b;
-  float m_ = L - 0.1055613458f * a - 0.0638541728f * b;
-  float s_ = L - 0.0894841775f * a - 1.2914855480f * b;
+// OKLab to linear-light sRGB, unclamped
+inline Rgbf ok_lab_to_linear(OkLabf c) {
+  float l_ = c.l + 0.3963377774f * c.a + 0.2158037573f * c.b;
+  float m_ = c.l - 0.1055613458f * c.a - 0.0638541728f * c.b;
+  float s_ = c.l - 0.0894841775f * c.a - 1.2914855480f * c.b;
 
   float l = l_ * l_ * l_;
   float m = m_ * m_ * m_;
   float s = s_ * s_ * s_;
 
-  float r1 = +4.0767416621f * l - 3.3077115913f * m + 0.2309699292f * s;
-  float g1 = -1.2684380046f * l + 2.6097574011f * m - 0.3413193965f * s;
-  float b1 = -0.0041960863f * l - 0.7034186147f * m + 1.7076147010f * s;
+  return {
+      +4.0767416621f * l - 3.3077115913f * m + 0.2309699292f * s,
+      -1.2684380046f * l + 2.6097574011f * m - 0.3413193965f * s,
+      -0.0041960863f * l - 0.7034186147f * m + 1.7076147010f * s,
+  };
+}
 
-  return {gamma(r1), gamma(g1), gamma(b1)};
+inline Rgbf to_rgb(OkLabf c) {
+  auto [r, g, b] = ok_lab_to_linear(c);
+  return {linear_to_srgb(r), linear_to_srgb(g), linear_to_srgb(b)};
+}
+
+// =========== okOK_LAB Space ==========
+
+inline Ok_Lab::Ok_Lab(float l, float a, float b) : Color(l, a, b) {}
+
+inline Ok_Lch_Ab Ok_Lab::to_ok_lch_ab() const {
+  auto [lightness, chroma, hue] = to_ok_lch({l(), a(), b()});
+
+  return Ok_Lch_Ab(lightness, chroma, hue);
+}
+
+inline Rgb Ok_Lab::to_rgb() const {
+  auto [red, green, blue] = clrspc::to_rgb(OkLabf{l(), a(), b()});
+
+  return {red, green, blue};
 }
 
 inline void Ok_Lab::print() const {
@@ -163,7 +226,8 @@ inline void Ok_Lab::print() const {
 inline Ok_Lch_Ab::Ok_Lch_Ab(float l, float c, float h) : Color(l, c, h) {}
 
 inline Ok_Lab Ok_Lch_Ab::to_ok_lab() const {
-  auto [l, a, b] = polar_to_cartesian(m_values);
+  auto [l, a, b] =
+      clrspc::to_ok_lab(OkLchf{m_values[0], m_values[1], m_values[2]});
 
   return Ok_Lab(l, a, b);
 }
@@ -181,33 +245,10 @@ inline Rgb::Rgb(Tristimulus channels)
     : Color(channels[0], channels[1], channels[2]) {}
 
 inline Ok_Lab Rgb::to_ok_lab() const {
-  auto linear = [](float c) {
-    c = std::fmax(0.f, c); // normalize and avoid negatives
-    return (c <= 0.04045f)
-               ? c / 12.92f
-               : std::exp2f(std::log2f((c + 0.055f) / 1.055f) * 2.4f);
-  };
-
-  float r_lin = linear(r());
-  float g_lin = linear(g());
-  float b_lin = linear(b());
+  auto [lightness, green_red, blue_yellow] =
+      clrspc::to_ok_lab(Rgbf{r(), g(), b()});
 
-  float l =
-      0.4122214708f * r_lin + 0.5363325363f * g_lin + 0.0514459929f * b_lin;
-  float m =
-      0.2119034982f * r_lin + 0.6806995451f * g_lin + 0.1073969566f * b_lin;
-  float s =
-      0.0883024619f * r_lin + 0.2817188376f * g_lin + 0.6299787005f * b_lin;
-
-  float l_ = cbrtf(l);
-  float m_ = cbrtf(m);
-  float s_ = cbrtf(s);
-
-  return {
-      0.2104542553f * l_ + 0.7936177850f * m_ - 0.0040720468f * s_,
-      1.9779984951f * l_ - 2.4285922050f * m_ + 0.4505937099f * s_,
-      0.0259040371f * l_ + 0.7827717662f * m_ - 0.8086757660f * s_,
-  };
+  return {lightness, green_red, blue_yellow};
 }
 
 inline void Rgb::print() const {
@@ -216,6 +257,390 @@ inline void Rgb::print() const {
             << std::endl;
 }
 
+// ========== Lookup tables ==========
+//
+// The sRGB transfer curves for 8-bit channels, tabulated once at startup
+// from srgb_to_linear and linear_to_srgb. test/srgbLut.cpp, run by
+// make test, checks them against those functions for all 256 codes.
+
+// linear light of every 8-bit sRGB code
+inline const std::array<float, 256> SRGB8_TO_LINEAR = [] {
+  std::array<float, 256> table;
+  for (int i = 0; i < 256; i++)
+    table[i] = srgb_to_linear(i / 255.f);
+  return table;
+}();
+
+// 8-bit sRGB code of linear light sampled at 4096 even steps over [0, 1];
+// fine enough that every code survives linear_to_srgb8(srgb8_to_linear(c))
+inline const std::array<uint8_t, 4096> LINEAR_TO_SRGB8 = [] {
+  std::array<uint8_t, 4096> table;
+  for (int i = 0; i < 4096; i++)
+    table[i] = static_cast<uint8_t>(
+        std::lround(std::fmin(1.f, linear_to_srgb(i / 4095.f)) * 255));
+  return table;
+}();
+
+/**
+ * @brief Linearizes an 8-bit sRGB channel by table lookup.
+ * @return linear light in [0, 1], as srgb_to_linear(c / 255.f)
+ */
+inline float srgb8_to_linear(uint8_t c) { return SRGB8_TO_LINEAR[c]; }
+
+/**
+ * @brief Gamma-encodes linear light to an 8-bit sRGB channel by table
+ * lookup, clamping to [0, 1]. Agrees with rounding linear_to_srgb(c) * 255
+ * to within one code; dark values lose most, as the curve is steepest there.
+ */
+inline uint8_t linear_to_srgb8(float c) {
+  const float index = std::fmin(std::fmax(c, 0.f), 1.f) * 4095.f + 0.5f;
+  return LINEAR_TO_SRGB8[static_cast<int>(index)];
+}
+
+// 8-bit sRGB to OKLab, linearizing through SRGB8_TO_LINEAR
+inline OkLabf to_ok_lab(Rgb8 c) {
+  return linear_to_ok_lab(srgb8_to_linear(c.r), srgb8_to_linear(c.g),
+                          srgb8_to_linear(c.b));
+}
+
+// OKLab to 8-bit sRGB, encoding through LINEAR_TO_SRGB8
+inline Rgb8 to_rgb8(OkLabf c) {
+  auto [r, g, b] = ok_lab_to_linear(c);
+  return {linear_to_srgb8(r), linear_to_srgb8(g), linear_to_srgb8(b)};
+}
+
+constexpr Rgb8 to_rgb8(Tristimulus c) { return {c[0], c[1], c[2]}; }
+
+// ========== Batch conversions ==========
+//
+// Structure-of-arrays versions of the conversions above for whole images:
+// each channel of n colors is its own contiguous float plane, sRGB is in
+// [0, 1] as Ok_Lab::to_rgb returns it, and hue is in degrees. The output
+// planes may be the input planes. On CPUs with AVX2 and FMA, eight colors
+// at a time go through polynomial approximations; the remainder, and every
+// color elsewhere, takes the scalar value conversions the classes use.
+//
+// Largest difference from the scalar path, over every 8-bit sRGB color and
+// its OKLab value, and over 64^3 OKLCh colors with L in [0, 1], C in
+// [0, 0.4) and hue in [-720, 720):
+//   srgb_to_ok_lab       3e-7 in L, 7e-7 in a and b
+//   ok_lab_to_srgb       2e-5, a two-hundredth of an 8-bit step; most of it
+//                        is the matrix's cancellation rounding differently
+//                        with fused multiply-adds
+//   ok_lch_ab_to_ok_lab  4e-7 in a and b
+
+namespace detail {
+
+inline void check_sizes(size_t n, std::initializer_list<size_t> sizes) {
+  for (size_t size : sizes)
+    if (size != n)
+      throw std::invalid_argument("color planes differ in size");
+}
+
+inline void srgb_to_ok_lab_scalar(float r, float g, float b, float &L,
+                                  float &a, float &b_out) {
+  const OkLabf lab = to_ok_lab(Rgbf{r, g, b});
+  L = lab.l;
+  a = lab.a;
+  b_out = lab.b;
+}
+
+#ifdef CLRSPC_AVX2
+
+#define CLRSPC_TARGET __attribute__((target("avx2,fma")))
+
+inline bool has_avx2() {
+  static const bool supported =
+      __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  return supported;
+}
+
+// log2 of positive normal floats: exponent plus the atanh series
+// 2/ln 2 (t + t^3/3 + t^5/5 + t^7/7), t = (m - 1) / (m + 1), m in
+// [sqrt(1/2), sqrt(2)), which truncates below 2e-8
+CLRSPC_TARGET inline __m256 log2_avx2(__m256 x) {
+  const __m256i bits = _mm256_castps_si256(x);
+  __m256i exponent =
+      _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127));
+  __m256 m = _mm256_castsi256_ps(
+      _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)),
+                      _mm256_set1_epi32(0x3f800000)));
+  const __m256 big = _mm256_cmp_ps(m, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+  m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), big);
+  exponent = _mm256_sub_epi32(exponent, _mm256_castps_si256(big)); // -1 is true
+
+  const __m256 one = _mm256_set1_ps(1.f);
+  const __m256 t = _mm256_div_ps(_mm256_sub_ps(m, one), _mm256_add_ps(m, one));
+  const __m256 t2 = _mm256_mul_ps(t, t);
+  __m256 p = _mm256_set1_ps(2.0f / 7 / 0.69314718f);
+  p = _mm256_fmadd_ps(p, t2, _mm256_set1_ps(2.0f / 5 / 0.69314718f));
+  p = _mm256_fmadd_ps(p, t2, _mm256_set1_ps(2.0f / 3 / 0.69314718f));
+  p = _mm256_fmadd_ps(p, t2, _mm256_set1_ps(2.0f / 0.69314718f));
+  return _mm256_fmadd_ps(p, t, _mm256_cvtepi32_ps(exponent));
+}
+
+// 2^x for x in [-126, 127]: 2^round(x) from the exponent bits times the
+// degree-6 Taylor series of e^(f ln 2), f in [-1/2, 1/2], which truncates
+// below 2e-7
+CLRSPC_TARGET inline __m256 exp2_avx2(__m256 x) {
+  x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-126.f)),
+                    _mm256_set1_ps(127.f));
+  const __m256 k = _mm256_round_ps(x, _MM_FROUND_TO_NEAREST_INT |
+                                          _MM_FROUND_NO_EXC);
+  const __m256 f = _mm256_mul_ps(_mm256_sub_ps(x, k), _mm256_set1_ps(0.69314718f));
+  __m256 p = _mm256_set1_ps(1.f / 720);
+  p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(1.f / 120));
+  p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(1.f / 24));
+  p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(1.f / 6));
+  p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(0.5f));
+  p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(1.f));
+  p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(1.f));
+  const __m256i scale = _mm256_slli_epi32(
+      _mm256_add_epi32(_mm256_cvtps_epi32(k), _mm256_set1_epi32(127)), 23);
+  return _mm256_mul_ps(p, _mm256_castsi256_ps(scale));
+}
+
+// cube root: a third of the exponent bits as first guess (3% off), then
+// three Newton steps y = (2y + x / y^2) / 3
+CLRSPC_TARGET inline __m256 cbrt_avx2(__m256 x) {
+  const __m256 sign = _mm256_set1_ps(-0.f);
+  const __m256 ax = _mm256_andnot_ps(sign, x);
+  const __m256i guess = _mm256_add_epi32(
+      _mm256_cvttps_epi32(_mm256_mul_ps(
+          _mm256_cvtepi32_ps(_mm256_castps_si256(ax)), _mm256_set1_ps(1.f / 3))),
+      _mm256_set1_epi32(709921077));
+  __m256 y = _mm256_castsi256_ps(guess);
+  const __m256 third = _mm256_set1_ps(1.f / 3);
+  for (int i = 0; i < 3; i++)
+    y = _mm256_mul_ps(_mm256_fmadd_ps(_mm256_set1_ps(2.f), y,
+                                      _mm256_div_ps(ax, _mm256_mul_ps(y, y))),
+                      third);
+  y = _mm256_and_ps(y, _mm256_cmp_ps(ax, _mm256_setzero_ps(), _CMP_NEQ_OQ));
+  return _mm256_or_ps(y, _mm256_and_ps(x, sign));
+}
+
+CLRSPC_TARGET inline __m256 srgb_to_linear_avx2(__m256 c) {
+  c = _mm256_max_ps(c, _mm256_setzero_ps());
+  const __m256 curve = exp2_avx2(_mm256_mul_ps(
+      log2_avx2(_mm256_mul_ps(_mm256_add_ps(c, _mm256_set1_ps(0.055f)),
+                              _mm256_set1_ps(1 / 1.055f))),
+      _mm256_set1_ps(2.4f)));
+  return _mm256_blendv_ps(curve, _mm256_mul_ps(c, _mm256_set1_ps(1 / 12.92f)),
+                          _mm256_cmp_ps(c, _mm256_set1_ps(0.04045f), _CMP_LE_OQ));
+}
+
+CLRSPC_TARGET inline __m256 linear_to_srgb_avx2(__m256 c) {
+  c = _mm256_max_ps(c, _mm256_setzero_ps());
+  const __m256 small = _mm256_cmp_ps(c, _mm256_set1_ps(0.0031308f), _CMP_LE_OQ);
+  // keeps log2 away from zero in the lanes the linear segment serves
+  const __m256 safe = _mm256_max_ps(c, _mm256_set1_ps(0.0031308f));
+  const __m256 curve = _mm256_fmsub_ps(
+      _mm256_set1_ps(1.055f),
+      exp2_avx2(_mm256_mul_ps(log2_avx2(safe), _mm256_set1_ps(0.41666f))),
+      _mm256_set1_ps(0.055f));
+  return _mm256_blendv_ps(curve, _mm256_mul_ps(c, _mm256_set1_ps(12.92f)), small);
+}
+
+// 3x3 matrix times three planes of eight
+CLRSPC_TARGET inline void mul3_avx2(const float (&m)[9], __m256 x, __m256 y,
+                                    __m256 z, __m256 &u, __m256 &v, __m256 &w) {
+  u = _mm256_fmadd_ps(_mm256_set1_ps(m[0]), x,
+                      _mm256_fmadd_ps(_mm256_set1_ps(m[1]), y,
+                                      _mm256_mul_ps(_mm256_set1_ps(m[2]), z)));
+  v = _mm256_fmadd_ps(_mm256_set1_ps(m[3]), x,
+                      _mm256_fmadd_ps(_mm256_set1_ps(m[4]), y,
+                                      _mm256_mul_ps(_mm256_set1_ps(m[5]), z)));
+  w = _mm256_fmadd_ps(_mm256_set1_ps(m[6]), x,
+                      _mm256_fmadd_ps(_mm256_set1_ps(m[7]), y,
+                                      _mm256_mul_ps(_mm256_set1_ps(m[8]), z)));
+}
+
+// the matrices of Rgb::to_ok_lab and Ok_Lab::to_rgb
+inline constexpr float RGB_TO_LMS[9] = {
+    0.4122214708f, 0.5363325363f, 0.0514459929f,
+    0.2119034982f, 0.6806995451f, 0.1073969566f,
+    0.0883024619f, 0.2817188376f, 0.6299787005f};
+inline constexpr float LMS_TO_LAB[9] = {
+    0.2104542553f, 0.7936177850f,  -0.0040720468f,
+    1.9779984951f, -2.4285922050f, 0.4505937099f,
+    0.0259040371f, 0.7827717662f,  -0.8086757660f};
+inline constexpr float LAB_TO_LMS[9] = {
+    1.f, 0.3963377774f,  0.2158037573f,
+    1.f, -0.1055613458f, -0.0638541728f,
+    1.f, -0.0894841775f, -1.2914855480f};
+inline constexpr float LMS_TO_RGB[9] = {
+    4.0767416621f,  -3.3077115913f, 0.2309699292f,
+    -1.2684380046f, 2.6097574011f,  -0.3413193965f,
+    -0.0041960863f, -0.7034186147f, 1.7076147010f};
+
+// each returns how many colors it converted, a multiple of eight
+CLRSPC_TARGET inline size_t srgb_to_ok_lab_avx2(const float *r, const float *g,
+                                                const float *b, float *L,
+                                                float *a, float *b_out,
+                                                size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 l, m, s, x, y, z;
+    mul3_avx2(RGB_TO_LMS, srgb_to_linear_avx2(_mm256_loadu_ps(r + i)),
+              srgb_to_linear_avx2(_mm256_loadu_ps(g + i)),
+              srgb_to_linear_avx2(_mm256_loadu_ps(b + i)), l, m, s);
+    mul3_avx2(LMS_TO_LAB, cbrt_avx2(l), cbrt_avx2(m), cbrt_avx2(s), x, y, z);
+    _mm256_storeu_ps(L + i, x);
+    _mm256_storeu_ps(a + i, y);
+    _mm256_storeu_ps(b_out + i, z);
+  }
+  return i;
+}
+
+CLRSPC_TARGET inline size_t ok_lab_to_srgb_avx2(const float *L, const float *a,
+                                                const float *b, float *r,
+                                                float *g, float *b_out,
+                                                size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 l, m, s, x, y, z;
+    mul3_avx2(LAB_TO_LMS, _mm256_loadu_ps(L + i), _mm256_loadu_ps(a + i),
+              _mm256_loadu_ps(b + i), l, m, s);
+    mul3_avx2(LMS_TO_RGB, _mm256_mul_ps(_mm256_mul_ps(l, l), l),
+              _mm256_mul_ps(_mm256_mul_ps(m, m), m),
+              _mm256_mul_ps(_mm256_mul_ps(s, s), s), x, y, z);
+    _mm256_storeu_ps(r + i, linear_to_srgb_avx2(x));
+    _mm256_storeu_ps(g + i, linear_to_srgb_avx2(y));
+    _mm256_storeu_ps(b_out + i, linear_to_srgb_avx2(z));
+  }
+  return i;
+}
+
+// sine and cosine of x: reduced by multiples of pi/2 (in two parts, for
+// precision) to [-pi/4, pi/4], where Taylor series to x^9 and x^8 are
+// within 3e-8, then swapped and negated by quadrant
+CLRSPC_TARGET inline void sincos_avx2(__m256 x, __m256 &sin, __m256 &cos) {
+  const __m256 q = _mm256_round_ps(
+      _mm256_mul_ps(x, _mm256_set1_ps(0.63661977f)),
+      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  __m256 r = _mm256_fnmadd_ps(q, _mm256_set1_ps(1.5707963705062866f), x);
+  r = _mm256_fnmadd_ps(q, _mm256_set1_ps(-4.371139000186243e-08f), r);
+  const __m256 r2 = _mm256_mul_ps(r, r);
+
+  __m256 s = _mm256_set1_ps(1.f / 362880);
+  s = _mm256_fmadd_ps(s, r2, _mm256_set1_ps(-1.f / 5040));
+  s = _mm256_fmadd_ps(s, r2, _mm256_set1_ps(1.f / 120));
+  s = _mm256_fmadd_ps(s, r2, _mm256_set1_ps(-1.f / 6));
+  s = _mm256_fmadd_ps(_mm256_mul_ps(s, r2), r, r);
+
+  __m256 c = _mm256_set1_ps(1.f / 40320);
+  c = _mm256_fmadd_ps(c, r2, _mm256_set1_ps(-1.f / 720));
+  c = _mm256_fmadd_ps(c, r2, _mm256_set1_ps(1.f / 24));
+  c = _mm256_fmadd_ps(c, r2, _mm256_set1_ps(-0.5f));
+  c = _mm256_fmadd_ps(c, r2, _mm256_set1_ps(1.f));
+
+  const __m256i quadrant = _mm256_cvtps_epi32(q);
+  const __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+      _mm256_and_si256(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+  const __m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+      _mm256_and_si256(quadrant, _mm256_set1_epi32(2)), 30));
+  const __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+      _mm256_and_si256(_mm256_add_epi32(quadrant, _mm256_set1_epi32(1)),
+                       _mm256_set1_epi32(2)),
+      30));
+  sin = _mm256_xor_ps(_mm256_blendv_ps(s, c, swap), sinSign);
+  cos = _mm256_xor_ps(_mm256_blendv_ps(c, s, swap), cosSign);
+}
+
+CLRSPC_TARGET inline size_t ok_lch_ab_to_ok_lab_avx2(const float *L,
+                                                     const float *c,
+                                                     const float *h, float *L_out,
+                                                     float *a, float *b,
+                                                     size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 sin, cos;
+    sincos_avx2(_mm256_mul_ps(_mm256_loadu_ps(h + i),
+                              _mm256_set1_ps(float(M_PI / 180))),
+                sin, cos);
+    const __m256 chroma = _mm256_loadu_ps(c + i);
+    _mm256_storeu_ps(L_out + i, _mm256_loadu_ps(L + i));
+    _mm256_storeu_ps(a + i, _mm256_mul_ps(chroma, cos));
+    _mm256_storeu_ps(b + i, _mm256_mul_ps(chroma, sin));
+  }
+  return i;
+}
+
+#undef CLRSPC_TARGET
+
+#endif // CLRSPC_AVX2
+
+} // namespace detail
+
+/**
+ * @brief Converts sRGB colors to OKLab, one plane per channel.
+ * @throws std::invalid_argument if the planes differ in size
+ */
+inline void srgb_to_ok_lab(std::span<const float> r, std::span<const float> g,
+                           std::span<const float> b, std::span<float> L,
+                           std::span<float> a, std::span<float> b_out) {
+  const size_t n = r.size();
+  detail::check_sizes(n, {g.size(), b.size(), L.size(), a.size(), b_out.size()});
+  size_t i = 0;
+#ifdef CLRSPC_AVX2
+  if (detail::has_avx2())
+    i = detail::srgb_to_ok_lab_avx2(r.data(), g.data(), b.data(), L.data(),
+                                    a.data(), b_out.data(), n);
+#endif
+  for (; i < n; i++)
+    detail::srgb_to_ok_lab_scalar(r[i], g[i], b[i], L[i], a[i], b_out[i]);
+}
+
+/**
+ * @brief Converts OKLab colors to sRGB in [0, 1] (unclamped above 1), one
+ * plane per channel.
+ * @throws std::invalid_argument if the planes differ in size
+ */
+inline void ok_lab_to_srgb(std::span<const float> L, std::span<const float> a,
+                           std::span<const float> b, std::span<float> r,
+                           std::span<float> g, std::span<float> b_out) {
+  const size_t n = L.size();
+  detail::check_sizes(n, {a.size(), b.size(), r.size(), g.size(), b_out.size()});
+  size_t i = 0;
+#ifdef CLRSPC_AVX2
+  if (detail::has_avx2())
+    i = detail::ok_lab_to_srgb_avx2(L.data(), a.data(), b.data(), r.data(),
+                                    g.data(), b_out.data(), n);
+#endif
+  for (; i < n; i++) {
+    const Rgbf rgb = to_rgb(OkLabf{L[i], a[i], b[i]});
+    r[i] = rgb.r;
+    g[i] = rgb.g;
+    b_out[i] = rgb.b;
+  }
+}
+
+/**
+ * @brief Converts OKLCh colors (hue in degrees) to OKLab, one plane per
+ * channel.
+ * @throws std::invalid_argument if the planes differ in size
+ */
+inline void ok_lch_ab_to_ok_lab(std::span<const float> L,
+                                std::span<const float> c,
+                                std::span<const float> h,
+                                std::span<float> L_out, std::span<float> a,
+                                std::span<float> b) {
+  const size_t n = L.size();
+  detail::check_sizes(n, {c.size(), h.size(), L_out.size(), a.size(), b.size()});
+  size_t i = 0;
+#ifdef CLRSPC_AVX2
+  if (detail::has_avx2())
+    i = detail::ok_lch_ab_to_ok_lab_avx2(L.data(), c.data(), h.data(),
+                                         L_out.data(), a.data(), b.data(), n);
+#endif
+  for (; i < n; i++) {
+    auto [l_, a_, b_] = polar_to_cartesian({L[i], c[i], h[i]});
+    L_out[i] = l_;
+    a[i] = a_;
+    b[i] = b_;
+  }
+}
+
 auto inline clamp255 = [](float x) {
   return static_cast<uint8_t>(std::max(0.f, std::min(1.f, x)) * 255);
 };
@@ -244,7 +669,9 @@ get_rainbow_colors(int sample_count, Tristimulus start_color = {255, 0, 0},
   float const sample_degrees = (360.0f * rainbow_percent) / 100.0f;
 
   float start_hue =
-      clrspc::Rgb(start_color).to_ok_lab().to_ok_lch_ab().get_values()[2];
+      to_ok_lch(to_ok_lab(Rgbf{float(start_color[0]), float(start_color[1]),
+                               float(start_color[2])}))
+          .h;
 
   start_hue -= 20.f; // offset to match perceived color
 
@@ -256,9 +683,7 @@ get_rainbow_colors(int sample_count, Tristimulus start_color = {255, 0, 0},
     float const hue = clrspc::normalize_degrees(
         start_hue + (sample_degrees * i) / (sample_count - 1));
 
-    clrspc::Ok_Lch_Ab const ok_lch_ab(LIGHTNESS, CHROMA, hue);
-
-    auto const [r, g, b] = ok_lch_ab.to_ok_lab().to_rgb().get_values();
+    auto const [r, g, b] = to_rgb(to_ok_lab(OkLchf{LIGHTNESS, CHROMA, hue}));
 
     colors.push_back({clamp255(r), clamp255(g), clamp255(b)});
   }
@@ -266,4 +691,27 @@ get_rainbow_colors(int sample_count, Tristimulus start_color = {255, 0, 0},
   return colors;
 }
 
+// ========== Formatting ==========
+//
+// Printing for the value types, kept apart from them so they stay plain
+// data. Writes e.g. "Rgb8(255, 0, 0)" or
+// "OkLab(0.627955, 0.224863, 0.125846)".
+
+inline std::ostream &operator<<(std::ostream &out, Rgb8 c) {
+  return out << "Rgb8(" << int(c.r) << ", " << int(c.g) << ", " << int(c.b)
+             << ")";
+}
+
+inline std::ostream &operator<<(std::ostream &out, Rgbf c) {
+  return out << "Rgb(" << c.r << ", " << c.g << ", " << c.b << ")";
+}
+
+inline std::ostream &operator<<(std::ostream &out, OkLabf c) {
+  return out << "OkLab(" << c.l << ", " << c.a << ", " << c.b << ")";
+}
+
+inline std::ostream &operator<<(std::ostream &out, OkLchf c) {
+  return out << "OkLch(" << c.l << ", " << c.c << ", " << c.h << ")";
+}
+
 } // namespace clrspc
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <type_traits>
+
+namespace clrspc {
+
+// ========== Value types ==========
+//
+// Plain aggregates for hot loops: no vtable, trivial (so arrays of them
+// are left uninitialized and copied as bytes) and usable in constant
+// expressions. The Color classes in Color_Space.h keep the object
+// interface for one-off use; the free conversions there take and return
+// these, and operator<< in Color_Space.h prints them.
+
+// an 8-bit gamma-encoded sRGB color, as pictures and PNG files store it
+struct Rgb8 {
+  uint8_t r;
+  uint8_t g;
+  uint8_t b;
+
+  constexpr bool operator==(const Rgb8 &) const = default;
+};
+
+// gamma-encoded sRGB with channels in [0, 1]
+struct Rgbf {
+  float r;
+  float g;
+  float b;
+
+  constexpr bool operator==(const Rgbf &) const = default;
+};
+
+// OKLab: lightness in [0, 1] and the green-red and blue-yellow axes
+struct OkLabf {
+  float l;
+  float a;
+  float b;
+
+  constexpr bool operator==(const OkLabf &) const = default;
+};
+
+// OKLCH: lightness, chroma and hue in degrees
+struct OkLchf {
+  float l;
+  float c;
+  float h;
+
+  constexpr bool operator==(const OkLchf &) const = default;
+};
+
+static_assert(std::is_trivial_v<Rgb8> && sizeof(Rgb8) == 3);
+static_assert(std::is_trivial_v<Rgbf> && sizeof(Rgbf) == 12);
+static_assert(std::is_trivial_v<OkLabf> && sizeof(OkLabf) == 12);
+static_assert(std::is_trivial_v<OkLchf> && sizeof(OkLchf) == 12);
+
+// ========== 8-bit conversions ==========
+
+// rounds a [0, 1] channel to 8 bits, clamping values outside that range
+constexpr uint8_t to_channel8(float c) {
+  c = c < 0.f ? 0.f : c > 1.f ? 1.f : c;
+  return static_cast<uint8_t>(c * 255.f + .5f);
+}
+
+constexpr Rgbf to_rgbf(Rgb8 c) {
+  return {c.r / 255.f, c.g / 255.f, c.b / 255.f};
+}
+
+constexpr Rgb8 to_rgb8(Rgbf c) {
+  return {to_channel8(c.r), to_channel8(c.g), to_channel8(c.b)};
+}
+
+constexpr Rgb8 gray8(uint8_t level) { return {level, level, level}; }
+
+/**
+ * @brief Packs an opaque color into the 4 RGBA bytes a picture stores per
+ * pixel, as one word in memory order, so a loop can store it with a
+ * single memcpy.
+ */
+constexpr uint32_t to_rgba_word(Rgb8 c) {
+  return std::bit_cast<uint32_t>(std::array<uint8_t, 4>{c.r, c.g, c.b, 255});
+}
+
+} // namespace clrspc
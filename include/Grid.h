@@ -0,0 +1,159 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "GridLayout.h"
+#include "GridStorage.h"
+
+enum cellState : uint8_t { WALL, UNVISITED, VISITED, PATH, WRONG_PATH };
+
+/**
+   A packed maze grid. Cells live in one contiguous buffer, placed by the
+   Layout policy (see GridLayout.h). In the row-major Grid a neighbor is a
+   constant offset away (+-1 horizontally, +-stride() vertically), which
+   lets the hot loops of the generators skip the per-access bounds checks
+   of nested vectors; tiled and Z-order grids keep vertical neighbors close
+   in memory instead and are indexed by coordinates.
+
+   The buffer is on the heap or, for grids too big for memory, in a mapped
+   file (see GridStorage); the generators and the solver only see data()
+   and cannot tell the difference.
+*/
+template <class Layout> class BasicGrid {
+public:
+  /**
+     Constructs an empty grid with width and height zero.
+     @param storage where the cells will live once the grid is assigned
+  */
+  explicit BasicGrid(GridStorage storage = GridStorage::MEMORY)
+      : _cells(GridAllocator<cellState>(storage)), _width(0), _height(0) {}
+
+  /**
+     Constructs a grid with every cell set to the given state.
+     @param width the width of the grid
+     @param height the height of the grid
+     @param fill the initial state of every cell
+     @param storage where the cells live
+  */
+  BasicGrid(int width, int height, cellState fill = UNVISITED,
+            GridStorage storage = GridStorage::MEMORY)
+      : _layout(width, height),
+        _cells(_layout.size(), fill, GridAllocator<cellState>(storage)),
+        _width(width), _height(height) {
+    advise(GridAccess::NORMAL);
+  }
+
+  GridStorage storage() const { return _cells.get_allocator().storage(); }
+
+  /**
+     Tells the kernel how the cells of a mapped grid are about to be used;
+     does nothing for a grid on the heap.
+  */
+  void advise(GridAccess access) const { adviseCells(_cells.size(), access); }
+
+  int width() const { return _width; }
+  int height() const { return _height; }
+
+  /**
+     Returns the distance in cells between two vertically adjacent cells.
+  */
+  ptrdiff_t stride() const
+    requires Layout::ROW_MAJOR
+  {
+    return _layout.stride();
+  }
+
+  /**
+     Returns the number of cells in the buffer, padding included.
+  */
+  size_t size() const { return _cells.size(); }
+
+  size_t index(int x, int y) const { return _layout.index(x, y); }
+
+  /**
+     Resizes the grid and sets every cell to the given state. Keeps the
+     existing allocation when it is large enough, so a grid can be reused
+     across mazes without reallocating.
+  */
+  void assign(int width, int height, cellState fill = UNVISITED) {
+    _layout = Layout(width, height);
+    _width = width;
+    _height = height;
+    // The fill runs front to back. A buffer that has to grow is a new
+    // mapping, which mapTemporary() already advises as sequential.
+    const size_t size = _layout.size();
+    if (size <= _cells.capacity())
+      adviseCells(size, GridAccess::SEQUENTIAL);
+    _cells.assign(size, fill);
+    advise(GridAccess::NORMAL);
+  }
+
+  /**
+     Yields the cell at the given position.
+     @throws std::out_of_range if the point is not in the grid
+  */
+  cellState &at(int x, int y) {
+    if (x < 0 || x >= _width || y < 0 || y >= _height)
+      throw std::out_of_range("Grid position out of range.");
+    return _cells[index(x, y)];
+  }
+
+  const cellState &at(int x, int y) const {
+    return const_cast<BasicGrid *>(this)->at(x, y);
+  }
+
+  /**
+     Unchecked access by flat index.
+  */
+  cellState &operator[](size_t i) { return _cells[i]; }
+  const cellState &operator[](size_t i) const { return _cells[i]; }
+
+  cellState *data() { return _cells.data(); }
+  const cellState *data() const { return _cells.data(); }
+
+private:
+  // advises the first count cells of the buffer
+  void adviseCells(size_t count, GridAccess access) const {
+    if (storage() == GridStorage::MAPPED && count > 0)
+      adviseMapping(_cells.data(), count, access);
+  }
+
+  Layout _layout;
+  std::vector<cellState, GridAllocator<cellState>> _cells;
+  int _width;
+  int _height;
+};
+
+using Grid = BasicGrid<RowMajor>;
+
+/**
+   Copies the cells of a grid into another of any layout, resizing it.
+*/
+template <class ToLayout, class FromLayout>
+void copyGrid(const BasicGrid<FromLayout> &from, BasicGrid<ToLayout> &to) {
+  to.assign(from.width(), from.height());
+  for (int y = 0; y < from.height(); y++)
+    for (int x = 0; x < from.width(); x++)
+      to[to.index(x, y)] = from[from.index(x, y)];
+}
+
+/**
+   Checks that a grid and start cell fit the maze lattice used by the
+   generators: odd dimensions and a start cell on even interior coordinates.
+   @throws std::runtime_error if they do not
+*/
+template <class Layout>
+void requireMazeLattice(const BasicGrid<Layout> &grid, int startX,
+                        int startY) {
+  if (grid.width() % 2 == 0 || grid.height() % 2 == 0)
+    throw std::runtime_error("Grid width and height must be odd.");
+  if (startX % 2 || startY % 2 || startX < 2 || startY < 2 ||
+      startX > grid.width() - 3 || startY > grid.height() - 3)
+    throw std::runtime_error("Start cell must be an even interior point.");
+}
+
+#endif
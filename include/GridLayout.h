@@ -0,0 +1,111 @@
+#ifndef GRIDLAYOUT_H
+#define GRIDLAYOUT_H
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+// ========== Layout policies ==========
+//
+// A layout maps grid coordinates to an offset into the cell buffer. It is
+// the template parameter of BasicGrid, so index() is inlined and every
+// layout compiles into its own loops. A layout is built from the grid size
+// and reports how many cells it needs, which may exceed width * height when
+// it pads the grid to whole tiles.
+//
+// Only ROW_MAJOR layouts have a constant distance between vertical
+// neighbors, so stride() and the offset arithmetic of the generators and
+// the solver are limited to them; the others index by coordinates.
+
+/**
+   Row after row, the layout of Grid. A vertical step is width() cells away,
+   which for wide grids is a new cache line and often a new page.
+*/
+struct RowMajor {
+  static constexpr bool ROW_MAJOR = true;
+
+  RowMajor(int width = 0, int height = 0) : _width(width), _height(height) {}
+
+  size_t size() const { return size_t(_width) * _height; }
+  size_t index(int x, int y) const { return size_t(y) * _width + x; }
+  ptrdiff_t stride() const { return _width; }
+
+private:
+  int _width;
+  int _height;
+};
+
+/**
+   Square tiles of Side x Side cells, row-major inside a tile, and the
+   tiles themselves row after row. Any step within a tile stays inside
+   Side * Side bytes; with the default 64 that is one 4 KiB page. The grid
+   is padded to whole tiles.
+*/
+template <int Side = 64> struct Tiled {
+  static_assert(Side > 0 && (Side & (Side - 1)) == 0,
+                "Side must be a power of two");
+  static constexpr bool ROW_MAJOR = false;
+  static constexpr int SHIFT = std::countr_zero(unsigned(Side));
+
+  Tiled(int width = 0, int height = 0)
+      : _tilesPerRow((width + Side - 1) >> SHIFT),
+        _tileRows((height + Side - 1) >> SHIFT) {}
+
+  size_t size() const { return size_t(_tilesPerRow) * _tileRows * Side * Side; }
+
+  size_t index(int x, int y) const {
+    const size_t tile = size_t(y >> SHIFT) * _tilesPerRow + (x >> SHIFT);
+    return (tile << 2 * SHIFT) + ((y & (Side - 1)) << SHIFT) + (x & (Side - 1));
+  }
+
+private:
+  int _tilesPerRow;
+  int _tileRows;
+};
+
+/**
+   Z-order (Morton) layout: the bits of x and y interleaved, so every
+   aligned 2^k x 2^k square of the grid is contiguous at every k. Both
+   sides are padded to a power of two; a grid with one side longer than
+   the other is a row of such Z-ordered squares. The padding can take up
+   to four times the cells of the grid (16384^2 for 10001^2), though pages
+   that are never touched are never faulted in.
+*/
+struct ZOrder {
+  static constexpr bool ROW_MAJOR = false;
+
+  ZOrder(int width = 0, int height = 0)
+      : _xBits(bitsFor(width)), _yBits(bitsFor(height)),
+        _squareBits(_xBits < _yBits ? _xBits : _yBits) {}
+
+  size_t size() const { return size_t(1) << (_xBits + _yBits); }
+
+  size_t index(int x, int y) const {
+    const uint32_t mask = (uint32_t(1) << _squareBits) - 1;
+    const size_t square = size_t((uint32_t(x) | uint32_t(y)) >> _squareBits);
+    return (square << 2 * _squareBits) | spread(uint32_t(x) & mask) |
+           spread(uint32_t(y) & mask) << 1;
+  }
+
+private:
+  static int bitsFor(int side) {
+    return side > 1 ? std::bit_width(unsigned(side - 1)) : 0;
+  }
+
+  // moves bit i of v to bit 2i
+  static uint64_t spread(uint32_t v) {
+    uint64_t r = v;
+    r = (r | r << 16) & 0x0000FFFF0000FFFFull;
+    r = (r | r << 8) & 0x00FF00FF00FF00FFull;
+    r = (r | r << 4) & 0x0F0F0F0F0F0F0F0Full;
+    r = (r | r << 2) & 0x3333333333333333ull;
+    r = (r | r << 1) & 0x5555555555555555ull;
+    return r;
+  }
+
+  int _xBits;
+  int _yBits;
+  int _squareBits;
+};
+
+#endif
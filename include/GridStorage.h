@@ -0,0 +1,85 @@
+#ifndef GRIDSTORAGE_H
+#define GRIDSTORAGE_H
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+/**
+   Where the cells of a Grid live.
+
+   MEMORY is the heap. MAPPED is a shared mapping of a sparse temporary
+   file, created in $TMPDIR (or /var/tmp) and unlinked at once, so it vanishes
+   with the mapping. Pages of a mapped grid are backed by that file rather
+   than by swap, so the kernel can write them out and drop them when
+   memory runs short, and a grid can be larger than physical memory.
+   Where mmap is not available, MAPPED falls back to the heap.
+*/
+enum class GridStorage { MEMORY, MAPPED };
+
+/**
+   Access patterns to announce for a mapped grid with madvise. They only
+   tune readahead and reclaim; every pattern works with any access.
+*/
+enum class GridAccess {
+  NORMAL,     // the kernel's default readahead around faults
+  SEQUENTIAL, // one pass from front to back, as a fill or a file write
+  RANDOM      // scattered single cells; no readahead
+};
+
+/**
+   Maps a zero-filled temporary file of the given size.
+   @throws std::system_error if the file cannot be created or mapped
+*/
+void *mapTemporary(size_t bytes);
+
+void unmapTemporary(void *address, size_t bytes);
+
+void adviseMapping(const void *address, size_t bytes, GridAccess access);
+
+/**
+   The allocator behind Grid's cell vector, which sends the vector's single
+   buffer to the heap or to mapTemporary(). A grid keeps its storage when
+   another grid is assigned to it, so assigning a heap grid to a mapped
+   one copies the cells into the mapping.
+*/
+template <class T> class GridAllocator {
+public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::false_type;
+  using propagate_on_container_move_assignment = std::false_type;
+  using propagate_on_container_swap = std::true_type;
+  using is_always_equal = std::false_type;
+
+  GridAllocator(GridStorage storage = GridStorage::MEMORY) noexcept
+      : _storage(storage) {}
+
+  template <class U>
+  GridAllocator(const GridAllocator<U> &other) noexcept
+      : _storage(other.storage()) {}
+
+  GridStorage storage() const { return _storage; }
+
+  T *allocate(size_t n) {
+    if (_storage == GridStorage::MAPPED)
+      return static_cast<T *>(mapTemporary(n * sizeof(T)));
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T *p, size_t n) {
+    if (_storage == GridStorage::MAPPED)
+      unmapTemporary(p, n * sizeof(T));
+    else
+      std::allocator<T>().deallocate(p, n);
+  }
+
+  template <class U>
+  bool operator==(const GridAllocator<U> &other) const {
+    return _storage == other.storage();
+  }
+
+private:
+  GridStorage _storage;
+};
+
+#endif
@@ -0,0 +1,182 @@
+#ifndef GROWING_TREE_H
+#define GROWING_TREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "Grid.h"
+#include "Random.h"
+
+// ========== Selection policies ==========
+//
+// A policy picks which active cell the growing tree extends next. It is a
+// template parameter of GrowingTree, so the call is inlined and each policy
+// compiles into its own specialized loop.
+
+/**
+   Always extends the most recently added cell; equivalent to the recursive
+   backtracker.
+*/
+struct NewestCell {
+  template <class Rng> size_t operator()(size_t count, Rng &) const {
+    return count - 1;
+  }
+};
+
+/**
+   Extends a uniformly random active cell; produces Prim-like mazes with
+   many short dead ends.
+*/
+struct RandomCell {
+  template <class Rng> size_t operator()(size_t count, Rng &rng) const {
+    return boundedRandom(rng, static_cast<uint32_t>(count));
+  }
+};
+
+/**
+   Extends the newest cell NewestPercent percent of the time and a random
+   cell otherwise. Because exhausted cells are swap-removed, "newest" is the
+   cell at the back of the active set, which is the most recent push except
+   right after a random cell was retired.
+*/
+template <unsigned NewestPercent> struct MixedCell {
+  static_assert(NewestPercent <= 100, "NewestPercent must be within 0..100");
+
+  template <class Rng> size_t operator()(size_t count, Rng &rng) const {
+    if (boundedRandom(rng, 100) < NewestPercent)
+      return count - 1;
+    return boundedRandom(rng, static_cast<uint32_t>(count));
+  }
+};
+
+// ========== Generator ==========
+
+/**
+   Growing-tree maze generator. Keeps a flat array of active cell indices;
+   each step asks SelectPolicy for one of them, carves into a random
+   unvisited neighbor, and retires the cell with an O(1) swap-remove once it
+   has none left.
+
+   The active array is kept between calls to generate(), so a generator
+   reused across mazes only allocates when a maze outgrows all previous ones.
+*/
+template <class SelectPolicy, class Rng = std::mt19937> class GrowingTree {
+public:
+  explicit GrowingTree(Rng rng = Rng(), SelectPolicy policy = SelectPolicy())
+      : _rng(rng), _policy(policy) {}
+
+  /**
+     Carves a maze into a grid prepared by initializeMaze.
+     @param grid a grid with odd width and height
+     @param startX the x-coordinate of the first cell (even)
+     @param startY the y-coordinate of the first cell (even)
+     @throws std::runtime_error if the grid or start cell is not aligned to
+     the maze lattice
+  */
+  void generate(Grid &grid, int startX, int startY) {
+    requireMazeLattice(grid, startX, startY);
+
+    // The visited border built by initializeMaze keeps every offset below
+    // inside the grid, so the loop indexes without bounds checks.
+    const ptrdiff_t stride = grid.stride();
+    const ptrdiff_t offsets[4] = {-2 * stride, 2 * stride, -2, 2};
+    cellState *cells = grid.data();
+
+    const size_t start = grid.index(startX, startY);
+    cells[start] = VISITED;
+    _active.clear();
+    _active.push_back(start);
+
+    while (!_active.empty()) {
+      const size_t i = _policy(_active.size(), _rng);
+      const ptrdiff_t curr = _active[i];
+
+      ptrdiff_t options[4];
+      uint32_t optionCount = 0;
+      for (ptrdiff_t offset : offsets) {
+        options[optionCount] = offset;
+        optionCount += cells[curr + offset] != VISITED;
+      }
+
+      if (optionCount == 0) {
+        _active[i] = _active.back(); // swap-remove the exhausted cell
+        _active.pop_back();
+        continue;
+      }
+
+      const ptrdiff_t offset =
+          options[optionCount == 1 ? 0 : boundedRandom(_rng, optionCount)];
+      cells[curr + offset / 2] = VISITED; // create a break in a wall
+      cells[curr + offset] = VISITED;
+      _active.push_back(curr + offset);
+    }
+  }
+
+  /**
+     Carves the same maze as generate(Grid &, ...) into a grid of another
+     layout, drawing the same random numbers. Without a constant stride it
+     keeps coordinates in the active array and indexes through the layout.
+  */
+  template <class Layout>
+    requires(!Layout::ROW_MAJOR)
+  void generate(BasicGrid<Layout> &grid, int startX, int startY) {
+    requireMazeLattice(grid, startX, startY);
+
+    // up, down, left, right, in the order of the row-major offsets
+    const int dx[4] = {0, 0, -2, 2};
+    const int dy[4] = {-2, 2, 0, 0};
+    cellState *cells = grid.data();
+
+    cells[grid.index(startX, startY)] = VISITED;
+    _active.clear();
+    _active.push_back(pack(startX, startY));
+
+    while (!_active.empty()) {
+      const size_t i = _policy(_active.size(), _rng);
+      const int x = int(_active[i] & 0xFFFFFFFF);
+      const int y = int(_active[i] >> 32);
+
+      int options[4];
+      uint32_t optionCount = 0;
+      for (int dir = 0; dir < 4; dir++) {
+        options[optionCount] = dir;
+        optionCount +=
+            cells[grid.index(x + dx[dir], y + dy[dir])] != VISITED;
+      }
+
+      if (optionCount == 0) {
+        _active[i] = _active.back(); // swap-remove the exhausted cell
+        _active.pop_back();
+        continue;
+      }
+
+      const int dir =
+          options[optionCount == 1 ? 0 : boundedRandom(_rng, optionCount)];
+      cells[grid.index(x + dx[dir] / 2, y + dy[dir] / 2)] = VISITED;
+      cells[grid.index(x + dx[dir], y + dy[dir])] = VISITED;
+      _active.push_back(pack(x + dx[dir], y + dy[dir]));
+    }
+  }
+
+  Rng &rng() { return _rng; }
+
+  /**
+     Returns the bytes held by the active array, i.e. the peak working set
+     of every maze generated so far.
+  */
+  size_t workspaceBytes() const { return _active.capacity() * sizeof(size_t); }
+
+private:
+  static size_t pack(int x, int y) { return uint64_t(y) << 32 | uint32_t(x); }
+
+  std::vector<size_t> _active;
+  Rng _rng;
+  SelectPolicy _policy;
+};
+
+using Backtracker = GrowingTree<NewestCell>;
+using PrimLike = GrowingTree<RandomCell>;
+
+#endif
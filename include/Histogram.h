@@ -0,0 +1,138 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+/**
+   Log-bucketed latency histogram in the style of HdrHistogram. Values
+   below 16 get a bucket each; above that every power of two is split into
+   16 linear sub-buckets, so any recorded value is known to within 1/16
+   (6.25%) while the whole 64-bit range fits in 976 counters.
+
+   One thread records; any thread may read or merge concurrently, because
+   every counter is an atomic updated with relaxed load/store pairs.
+*/
+class Histogram {
+public:
+    inline static int const SUB_BUCKET_BITS = 4;
+    inline static int const SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    inline static size_t const BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    inline static size_t bucketIndex(uint64_t value)
+    {
+        if (value < SUB_BUCKETS) {
+            return static_cast<size_t>(value);
+        }
+        int const shift = 63 - __builtin_clzll(value) - SUB_BUCKET_BITS;
+        return static_cast<size_t>((shift + 1) * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS));
+    }
+
+    inline static uint64_t bucketLow(size_t index)
+    {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        int const shift = static_cast<int>(index / SUB_BUCKETS) - 1;
+        return (index % SUB_BUCKETS + SUB_BUCKETS) << shift;
+    }
+
+    inline static uint64_t bucketHigh(size_t index)
+    {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        int const shift = static_cast<int>(index / SUB_BUCKETS) - 1;
+        return bucketLow(index) + ((uint64_t(1) << shift) - 1);
+    }
+
+    /**
+       Adds one value. Only one thread may record into a histogram.
+    */
+    inline void record(uint64_t value)
+    {
+        add(m_Counts[bucketIndex(value)], 1);
+        add(m_Sum, value);
+        if (value < m_Min.load(std::memory_order_relaxed)) {
+            m_Min.store(value, std::memory_order_relaxed);
+        }
+        if (value > m_Max.load(std::memory_order_relaxed)) {
+            m_Max.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+       Adds every value of another histogram to this one. Only the thread
+       that records into this histogram may merge into it.
+    */
+    inline void merge(Histogram const& other)
+    {
+        for (size_t i = 0; i < BUCKETS; i++) {
+            add(m_Counts[i], other.m_Counts[i].load(std::memory_order_relaxed));
+        }
+        add(m_Sum, other.sum());
+        m_Min.store(std::min(m_Min.load(std::memory_order_relaxed),
+                        other.m_Min.load(std::memory_order_relaxed)),
+            std::memory_order_relaxed);
+        m_Max.store(std::max(max(), other.max()), std::memory_order_relaxed);
+    }
+
+    /**
+       Returns the number of recorded values. Sums the buckets, so the
+       record path only has to touch one counter.
+    */
+    inline uint64_t count() const
+    {
+        uint64_t total = 0;
+        for (auto const& bucket : m_Counts) {
+            total += bucket.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    uint64_t sum() const { return m_Sum.load(std::memory_order_relaxed); }
+    uint64_t min() const { return std::min(m_Min.load(std::memory_order_relaxed), max()); }
+    uint64_t max() const { return m_Max.load(std::memory_order_relaxed); }
+
+    inline double mean() const
+    {
+        uint64_t const total = count();
+        return total ? double(sum()) / total : 0;
+    }
+
+    /**
+       Returns the value at the given percentile (0 to 100): the midpoint of
+       the bucket holding that rank, clamped to the recorded min and max.
+    */
+    inline uint64_t percentile(double percent) const
+    {
+        uint64_t const total = count();
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t const rank = std::max<uint64_t>(1,
+            static_cast<uint64_t>(std::min(percent, 100.0) / 100 * total + 0.5));
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; i++) {
+            seen += m_Counts[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                uint64_t const mid = bucketLow(i) + (bucketHigh(i) - bucketLow(i)) / 2;
+                return std::clamp(mid, min(), max());
+            }
+        }
+        return max();
+    }
+
+private:
+    inline static void add(std::atomic<uint64_t>& counter, uint64_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, BUCKETS> m_Counts {};
+    std::atomic<uint64_t> m_Sum { 0 };
+    std::atomic<uint64_t> m_Min { std::numeric_limits<uint64_t>::max() };
+    std::atomic<uint64_t> m_Max { 0 };
+};
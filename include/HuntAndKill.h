@@ -0,0 +1,195 @@
+#ifndef HUNT_AND_KILL_H
+#define HUNT_AND_KILL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "Grid.h"
+#include "Random.h"
+
+/**
+   Hunt-and-kill maze generator. Random-walks from the current cell until it
+   is boxed in, then hunts for an unvisited cell next to the visited region
+   and continues from there. It needs no stack, only a bitmap with one bit
+   per maze cell.
+
+   Cells are tracked in an "unvisited" bitmap of 64-bit words per row plus a
+   summary bitmap with one bit per row that still has unvisited cells. The
+   hunt skips finished rows through the summary and tests 64 cells at a time
+   for a visited neighbor, so it costs a few word operations instead of a
+   cell-by-cell scan of the grid.
+*/
+template <class Rng = std::mt19937> class HuntAndKill {
+public:
+  explicit HuntAndKill(Rng rng = Rng()) : _rng(rng) {}
+
+  /**
+     Carves a maze into a grid prepared by initializeMaze.
+     @param grid a grid with odd width and height
+     @param startX the x-coordinate of the first cell (even)
+     @param startY the y-coordinate of the first cell (even)
+     @throws std::runtime_error if the grid or start cell is not aligned to
+     the maze lattice
+  */
+  void generate(Grid &grid, int startX, int startY) {
+    requireMazeLattice(grid, startX, startY);
+    reset((grid.width() - 3) / 2, (grid.height() - 3) / 2);
+
+    const ptrdiff_t stride = grid.stride();
+    const ptrdiff_t offsets[4] = {-2 * stride, 2 * stride, -2, 2};
+    const int dx[4] = {0, 0, -1, 1};
+    const int dy[4] = {-1, 1, 0, 0};
+    cellState *cells = grid.data();
+
+    int cx = (startX - 2) / 2;
+    int cy = (startY - 2) / 2;
+    ptrdiff_t curr = grid.index(startX, startY);
+    cells[curr] = VISITED;
+    markVisited(cx, cy);
+    size_t remaining = size_t(_cols) * _rows - 1;
+
+    while (remaining > 0) {
+      // kill: walk to a random unvisited neighbor; the visited border keeps
+      // the offsets inside the grid
+      uint32_t options[4];
+      uint32_t optionCount = 0;
+      for (uint32_t dir = 0; dir < 4; dir++) {
+        options[optionCount] = dir;
+        optionCount += cells[curr + offsets[dir]] != VISITED;
+      }
+
+      if (optionCount == 0) {
+        // hunt: restart from an unvisited cell bordering the visited region
+        // and join it to one of its visited neighbors
+        hunt(cx, cy);
+        curr = grid.index(2 + 2 * cx, 2 + 2 * cy);
+
+        optionCount = 0;
+        for (uint32_t dir = 0; dir < 4; dir++) {
+          const int nx = cx + dx[dir];
+          const int ny = cy + dy[dir];
+          options[optionCount] = dir;
+          optionCount += nx >= 0 && nx < _cols && ny >= 0 && ny < _rows &&
+                         !isUnvisited(nx, ny);
+        }
+        const uint32_t dir =
+            options[optionCount == 1 ? 0 : boundedRandom(_rng, optionCount)];
+        cells[curr + offsets[dir] / 2] = VISITED; // create a break in a wall
+        cells[curr] = VISITED;
+        markVisited(cx, cy);
+        remaining--;
+        continue;
+      }
+
+      const uint32_t dir =
+          options[optionCount == 1 ? 0 : boundedRandom(_rng, optionCount)];
+      cells[curr + offsets[dir] / 2] = VISITED; // create a break in a wall
+      curr += offsets[dir];
+      cells[curr] = VISITED;
+      cx += dx[dir];
+      cy += dy[dir];
+      markVisited(cx, cy);
+      remaining--;
+    }
+  }
+
+  Rng &rng() { return _rng; }
+
+  /**
+     Returns the bytes held by the bitmaps and row counters.
+  */
+  size_t workspaceBytes() const {
+    return (_unvisited.capacity() + _rowSummary.capacity()) *
+               sizeof(uint64_t) +
+           _rowRemaining.capacity() * sizeof(uint32_t);
+  }
+
+private:
+  void reset(int cols, int rows) {
+    _cols = cols;
+    _rows = rows;
+    _rowWords = (cols + 63) / 64;
+    _lastWordMask = lowBits(cols - (_rowWords - 1) * 64);
+
+    _unvisited.assign(size_t(rows) * _rowWords, ~uint64_t(0));
+    for (int y = 0; y < rows; y++)
+      _unvisited[size_t(y) * _rowWords + _rowWords - 1] = _lastWordMask;
+
+    _rowRemaining.assign(rows, cols);
+
+    const size_t summaryWords = (rows + 63) / 64;
+    _rowSummary.assign(summaryWords, ~uint64_t(0));
+    _rowSummary.back() = lowBits(rows - int(summaryWords - 1) * 64);
+    _huntWord = 0;
+  }
+
+  static uint64_t lowBits(int count) {
+    return count >= 64 ? ~uint64_t(0) : (uint64_t(1) << count) - 1;
+  }
+
+  bool isUnvisited(int x, int y) const {
+    return (_unvisited[size_t(y) * _rowWords + x / 64] >> (x % 64)) & 1;
+  }
+
+  void markVisited(int x, int y) {
+    _unvisited[size_t(y) * _rowWords + x / 64] &= ~(uint64_t(1) << (x % 64));
+    if (--_rowRemaining[y] == 0)
+      _rowSummary[y / 64] &= ~(uint64_t(1) << (y % 64));
+  }
+
+  // visited cells of word w in row y; rows outside the maze have none
+  uint64_t visitedWord(int y, int w) const {
+    if (y < 0 || y >= _rows || w < 0 || w >= _rowWords)
+      return 0;
+    const uint64_t mask = w == _rowWords - 1 ? _lastWordMask : ~uint64_t(0);
+    return ~_unvisited[size_t(y) * _rowWords + w] & mask;
+  }
+
+  /**
+     Finds the first unvisited cell, in row-major order, with at least one
+     visited neighbor.
+  */
+  void hunt(int &cx, int &cy) {
+    // rows only ever lose unvisited cells, so finished summary words stay
+    // finished and the scan never has to look behind _huntWord
+    while (_rowSummary[_huntWord] == 0)
+      _huntWord++;
+
+    for (size_t s = _huntWord; s < _rowSummary.size(); s++) {
+      for (uint64_t rows = _rowSummary[s]; rows; rows &= rows - 1) {
+        const int y = int(s * 64) + __builtin_ctzll(rows);
+        const uint64_t *row = &_unvisited[size_t(y) * _rowWords];
+
+        for (int w = 0; w < _rowWords; w++) {
+          if (row[w] == 0)
+            continue;
+          const uint64_t visited = visitedWord(y, w);
+          const uint64_t touching =
+              visitedWord(y - 1, w) | visitedWord(y + 1, w) |
+              (visited << 1) | (visitedWord(y, w - 1) >> 63) |
+              (visited >> 1) | (visitedWord(y, w + 1) << 63);
+          const uint64_t candidates = row[w] & touching;
+          if (candidates) {
+            cx = w * 64 + __builtin_ctzll(candidates);
+            cy = y;
+            return;
+          }
+        }
+      }
+    }
+  }
+
+  std::vector<uint64_t> _unvisited;
+  std::vector<uint64_t> _rowSummary;
+  std::vector<uint32_t> _rowRemaining;
+  size_t _huntWord = 0;
+  uint64_t _lastWordMask = 0;
+  int _cols = 0;
+  int _rows = 0;
+  int _rowWords = 0;
+  Rng _rng;
+};
+
+#endif
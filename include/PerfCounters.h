@@ -0,0 +1,137 @@
+#pragma once
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+   Hardware performance counters of the calling thread, opened as one
+   perf_event_open group so that every event covers the same instructions.
+   Counts user space only, which works at the default perf_event_paranoid
+   level of 2. Each read() is a system call of about a microsecond, so
+   sample whole stages, not inner loops.
+
+   Events the CPU or hypervisor does not expose are left out of the group
+   and read as zero; if the leader (cycles) cannot be opened at all,
+   isOpen() is false and error() says why.
+*/
+class PerfCounters {
+public:
+    enum Event { CYCLES, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, DTLB_MISSES, EVENTS };
+
+    using Counts = std::array<uint64_t, EVENTS>;
+
+    inline static char const* eventName(int event)
+    {
+        static char const* const names[EVENTS]
+            = { "cycles", "instructions", "cache-misses", "branch-misses", "dTLB-misses" };
+        return names[event];
+    }
+
+    PerfCounters() = default;
+
+    inline ~PerfCounters() { close(); }
+
+    PerfCounters(PerfCounters const&) = delete;
+    PerfCounters& operator=(PerfCounters const&) = delete;
+
+    /**
+       Opens and starts the counters for the calling thread.
+       @return false if not even the cycle counter is available
+    */
+    inline bool open()
+    {
+#if defined(__linux__)
+        uint32_t const types[EVENTS] = { PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+            PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE };
+        uint64_t const configs[EVENTS] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES,
+            PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) };
+
+        for (int event = 0; event < EVENTS; event++) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = types[event];
+            attr.config = configs[event];
+            attr.disabled = m_Fds[CYCLES] < 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID;
+
+            int const fd = static_cast<int>(
+                syscall(SYS_perf_event_open, &attr, 0, -1, m_Fds[CYCLES], 0));
+            if (fd < 0) {
+                if (event == CYCLES) {
+                    m_Error = std::strerror(errno);
+                    return false;
+                }
+                continue;
+            }
+            m_Fds[event] = fd;
+            ioctl(fd, PERF_EVENT_IOC_ID, &m_Ids[event]);
+        }
+        ioctl(m_Fds[CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(m_Fds[CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        return true;
+#else
+        m_Error = "perf_event_open is Linux only";
+        return false;
+#endif
+    }
+
+    inline bool isOpen() const { return m_Fds[CYCLES] >= 0; }
+
+    inline bool hasEvent(int event) const { return m_Fds[event] >= 0; }
+
+    std::string const& error() const { return m_Error; }
+
+    /**
+       Reads the running totals of every event; missing events read as zero.
+    */
+    inline Counts read() const
+    {
+        Counts counts {};
+#if defined(__linux__)
+        // PERF_FORMAT_GROUP | PERF_FORMAT_ID: nr, then { value, id } per event.
+        uint64_t buffer[1 + 2 * EVENTS];
+        if (!isOpen() || ::read(m_Fds[CYCLES], buffer, sizeof(buffer)) <= 0) {
+            return counts;
+        }
+        for (uint64_t i = 0; i < buffer[0] && i < EVENTS; i++) {
+            for (int event = 0; event < EVENTS; event++) {
+                if (m_Fds[event] >= 0 && m_Ids[event] == buffer[2 + 2 * i]) {
+                    counts[event] = buffer[1 + 2 * i];
+                }
+            }
+        }
+#endif
+        return counts;
+    }
+
+private:
+    inline void close()
+    {
+#if defined(__linux__)
+        for (int& fd : m_Fds) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            fd = -1;
+        }
+#endif
+    }
+
+    std::array<int, EVENTS> m_Fds { -1, -1, -1, -1, -1 };
+    std::array<uint64_t, EVENTS> m_Ids {};
+    std::string m_Error;
+};
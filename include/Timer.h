@@ -1,63 +1,707 @@
 #pragma once
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
 #include <string>
-#include <unordered_map>
+#include <vector>
+
+#include "Histogram.h"
+#include "PerfCounters.h"
+#include "allocation.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Times the rest of the enclosing scope under the given zone name. The zone
+// is registered once per call site; afterwards a scope costs two clock reads,
+// one relaxed load of the mode flags and one store into a thread-local
+// buffer that is bucketed into the zone's histogram in batches, out of line.
+// The budget is 20 ns per scope on top of the two clock reads, whose own
+// cost depends on the machine (bench/timer.cpp measures both).
+#define TIMER_CONCAT_INNER(a, b) a##b
+#define TIMER_CONCAT(a, b) TIMER_CONCAT_INNER(a, b)
+#define TIMER_ZONE(name)                                                                           \
+    static Timer::Zone const TIMER_CONCAT(timerZone_, __LINE__) = Timer::registerZone(name);       \
+    Timer TIMER_CONCAT(timer_, __LINE__)(TIMER_CONCAT(timerZone_, __LINE__))
+
+// Like TIMER_ZONE, but the scope processes the given number of grid cells,
+// so that hardware counters are reported per cell instead of per call.
+#define TIMER_ZONE_ITEMS(name, items)                                                              \
+    static Timer::Zone const TIMER_CONCAT(timerZone_, __LINE__) = Timer::registerZone(name);       \
+    Timer TIMER_CONCAT(timer_, __LINE__)(TIMER_CONCAT(timerZone_, __LINE__), items)
 
 class Timer {
+public:
+    using Zone = uint32_t;
+
+    inline static size_t const MAX_ZONES = 128;
+
+    /**
+       Reads the clock scopes are timed with: the time stamp counter where
+       available (constant rate on every x86 CPU of the last decade, and
+       read without a fence, so it may run a few instructions early or
+       late), otherwise the steady clock in nanoseconds. The two reads are
+       most of what a scope costs.
+    */
+    inline static uint64_t readTicks()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+#endif
+    }
+
 private:
+    using Clock = std::chrono::steady_clock;
+
+    struct TraceEvent {
+        uint64_t startTicks;
+        uint64_t endTicks;
+        Zone zone;
+    };
+
+    struct ZoneCounters {
+        std::array<std::atomic<uint64_t>, PerfCounters::EVENTS> events {};
+        std::atomic<uint64_t> items { 0 };
+    };
+
+    struct ZoneMemory {
+        std::atomic<uint64_t> allocations { 0 };
+        std::atomic<uint64_t> bytes { 0 };
+        std::atomic<uint64_t> peak { 0 }; // largest growth of live bytes in one call
+    };
+
+    // Scopes waiting to be bucketed per thread, and how a waiting scope packs
+    // its zone above its ticks.
+    inline static uint32_t const PENDING = 64;
+    inline static int const ZONE_SHIFT = 56;
+    inline static uint64_t const MAX_PENDING_TICKS = (uint64_t(1) << ZONE_SHIFT) - 1;
+
+    // Every thread owns one of these and is its only writer. The histograms
+    // are allocated under the registry lock, for every registered zone when
+    // the thread registers and for every registered thread when a zone
+    // does, so a scope never allocates; Histogram's relaxed atomics make the
+    // concurrent reads in printData() race-free without any
+    // read-modify-write on the hot path.
+    struct ThreadTotals {
+        std::array<std::atomic<Histogram*>, MAX_ZONES> zones {};
+        uint32_t id = 0;
+
+        // The last scopes, not yet in the histograms; flushed when full.
+        std::array<std::atomic<uint64_t>, PENDING> pending {};
+        std::atomic<uint32_t> pendingCount { 0 };
+
+        // Ring buffer of the most recent traceCapacity scopes, allocated by
+        // the owning thread on its first scope after enableTrace().
+        std::unique_ptr<TraceEvent[]> trace;
+        std::atomic<uint64_t> traceCount { 0 };
+
+        // Hardware counters of the thread, opened on its first scope after
+        // enableCounters(), and their per-zone sums (MAX_ZONES entries).
+        std::unique_ptr<PerfCounters> counters;
+        std::atomic<ZoneCounters*> counterTotals { nullptr };
+
+        // Per-zone heap usage, allocated on the first scope after
+        // enableMemory() (MAX_ZONES entries).
+        std::atomic<ZoneMemory*> memoryTotals { nullptr };
+
+        ~ThreadTotals()
+        {
+            for (auto& zone : zones) {
+                delete zone.load();
+            }
+            delete[] counterTotals.load();
+            delete[] memoryTotals.load();
+        }
+    };
+
     inline static size_t const EXPECTED_MAX_DIGITS = 8;
-    inline static size_t maxLabelSize = 0;
-    inline static std::unordered_map<std::string, double> data = {};
-    inline static std::chrono::time_point<std::chrono::high_resolution_clock> m_GlobalStart;
+    inline static std::mutex registryMutex;
+    inline static std::vector<std::string> zoneNames = {};
+    inline static std::vector<std::unique_ptr<ThreadTotals>> threads = {};
+    inline static thread_local ThreadTotals* localTotals = nullptr;
+
+    // What every scope records besides its time, read once per scope.
+    enum Mode : unsigned {
+        TRACING = 1,
+        COUNTING = 2,
+        TRACKING_MEMORY = 4,
+    };
+    inline static std::atomic<unsigned> modes { 0 };
 
-    std::chrono::time_point<std::chrono::high_resolution_clock> m_StartTimepoint;
-    std::string label;
+    inline static size_t traceCapacity = 0;
+    inline static std::string tracePath;
+
+    inline static std::atomic<unsigned> countedEvents { 0 }; // bit per PerfCounters::Event
+    inline static std::string countersError;
+
+    inline static Clock::time_point const m_ClockBase = Clock::now();
+    inline static uint64_t const m_TickBase = readTicks();
+    inline static uint64_t m_GlobalStartTicks = m_TickBase;
+
+    uint64_t m_StartTicks;
+    Zone m_Zone;
+    unsigned m_Modes;
+    uint64_t m_Items;
+    PerfCounters::Counts m_StartCounts;
+    AllocationCounters m_StartMemory;
 
 public:
-    inline Timer(std::string const& label)
-        : m_StartTimepoint(std::chrono::high_resolution_clock::now())
-        , label(label)
+    /**
+       Starts timing a scope in a zone from registerZone().
+       @param items grid cells the scope processes, 0 if not applicable
+    */
+    inline explicit Timer(Zone zone, uint64_t items = 0)
+        : m_Zone(zone)
+        , m_Modes(modes.load(std::memory_order_relaxed))
+        , m_Items(items)
+    {
+        if (m_Modes != 0) {
+            startModes();
+        }
+        m_StartTicks = readTicks();
+    }
+
+    /**
+       Starts timing a scope by zone name. Looks the name up under a lock on
+       every call, so prefer TIMER_ZONE in anything hotter than a whole stage.
+    */
+    inline explicit Timer(std::string const& label)
+        : Timer(registerZone(label))
     {
     }
 
     inline ~Timer() { Stop(); }
 
-    inline static void printData()
+    Timer(Timer const&) = delete;
+    Timer& operator=(Timer const&) = delete;
+
+    /**
+       Returns the id of the zone with the given name, adding it on first use.
+       @throws std::length_error if more than MAX_ZONES names are registered
+    */
+    inline static Zone registerZone(std::string const& name)
     {
-        auto const endTimepoint = std::chrono::high_resolution_clock::now();
-        auto const globalDuration
-            = std::chrono::duration<double, std::milli>(endTimepoint - m_GlobalStart).count();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (size_t i = 0; i < zoneNames.size(); i++) {
+            if (zoneNames[i] == name) {
+                return static_cast<Zone>(i);
+            }
+        }
+        if (zoneNames.size() == MAX_ZONES) {
+            throw std::length_error("Timer supports at most 128 zones.");
+        }
+        zoneNames.push_back(name);
+        Zone const zone = static_cast<Zone>(zoneNames.size() - 1);
+        for (auto const& totals : threads) {
+            totals->zones[zone].store(new Histogram(), std::memory_order_release);
+        }
+        return zone;
+    }
 
-        size_t const borderSize = maxLabelSize + EXPECTED_MAX_DIGITS + 14;
+    /**
+       Merges the histograms of every thread and prints, in registration
+       order, each zone's total time, share of the time since Start() and
+       call count, followed by its latency distribution. Scopes that end
+       while this runs may be counted twice or not at all.
+       @param out where to print, standard error when standard output
+       carries the image
+    */
+    inline static void printData(std::ostream& out = std::cout)
+    {
+        double const msPerTick = millisecondsPerTick();
+        double const globalDuration = (readTicks() - m_GlobalStartTicks) * msPerTick;
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+
+        size_t maxLabelSize = 0;
+        for (auto const& name : zoneNames) {
+            maxLabelSize = std::max(maxLabelSize, name.size());
+        }
+
+        std::vector<std::unique_ptr<Histogram>> merged;
+        for (size_t zone = 0; zone < zoneNames.size(); zone++) {
+            merged.push_back(std::make_unique<Histogram>());
+        }
+        for (auto const& totals : threads) {
+            for (size_t zone = 0; zone < zoneNames.size(); zone++) {
+                merged[zone]->merge(*totals->zones[zone].load(std::memory_order_acquire));
+            }
+            uint32_t const pending = totals->pendingCount.load(std::memory_order_acquire);
+            for (uint32_t i = 0; i < pending; i++) {
+                uint64_t const scope = totals->pending[i].load(std::memory_order_relaxed);
+                merged[scope >> ZONE_SHIFT]->record(scope & MAX_PENDING_TICKS);
+            }
+        }
+
+        size_t const borderSize = maxLabelSize + 72;
         std::string const border(borderSize, '-');
 
-        std::cout << border << '\n';
+        out << border << '\n';
+
+        for (size_t zone = 0; zone < zoneNames.size(); zone++) {
+            Histogram const& histogram = *merged[zone];
+            if (histogram.count() == 0) {
+                continue;
+            }
+
+            double const milliseconds = histogram.sum() * msPerTick;
+            out << std::left << std::setw(maxLabelSize) << zoneNames[zone] << ": "
+                      << std::right << std::fixed << std::setw(EXPECTED_MAX_DIGITS)
+                      << std::setprecision(3) << milliseconds << " ms | " << std::setprecision(1)
+                      << std::setw(5) << (milliseconds / globalDuration) * 100 << "% | "
+                      << histogram.count() << " calls\n";
+        }
+        out << border << '\n';
+
+        char const* const columns[] = { "min", "mean", "p50", "p90", "p99", "p99.9", "max" };
+        out << std::left << std::setw(maxLabelSize) << "latency" << "  ";
+        for (char const* column : columns) {
+            out << std::right << std::setw(10) << column;
+        }
+        out << '\n';
 
-        for (auto const& pair : data) {
+        for (size_t zone = 0; zone < zoneNames.size(); zone++) {
+            Histogram const& histogram = *merged[zone];
+            if (histogram.count() == 0) {
+                continue;
+            }
 
-            std::cout << std::left << std::setw(maxLabelSize) << pair.first << ": " << std::right
-                      << std::fixed << std::setw(EXPECTED_MAX_DIGITS) << std::setprecision(3)
-                      << pair.second << " ms | " << std::setprecision(1)
-                      << (pair.second / globalDuration) * 100 << "%\n";
+            double const values[] = { double(histogram.min()), histogram.mean(),
+                double(histogram.percentile(50)), double(histogram.percentile(90)),
+                double(histogram.percentile(99)), double(histogram.percentile(99.9)),
+                double(histogram.max()) };
+            out << std::left << std::setw(maxLabelSize) << zoneNames[zone] << ": ";
+            for (double value : values) {
+                out << std::right << std::setw(10) << formatDuration(value * msPerTick);
+            }
+            out << '\n';
         }
-        std::cout << border << std::endl;
+        out << border << std::endl;
+
+        printCounters(out, maxLabelSize, merged);
+        printMemory(out, maxLabelSize, merged);
     }
 
-    inline static void Start() { m_GlobalStart = std::chrono::high_resolution_clock::now(); }
+    inline static void Start() { m_GlobalStartTicks = readTicks(); }
+
+    /**
+       Starts recording the begin and end of every scope, per thread, and
+       registers an exit handler that writes them to the given file as
+       Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev). Each
+       thread keeps only its most recent eventsPerThread scopes.
+       Call before starting worker threads; later calls are ignored.
+    */
+    inline static void enableTrace(std::string const& path, size_t eventsPerThread = 1 << 20)
+    {
+        if ((modes.load() & TRACING) || eventsPerThread == 0) {
+            return;
+        }
+        tracePath = path;
+        traceCapacity = eventsPerThread;
+        modes.fetch_or(TRACING);
+        std::atexit([] {
+            std::ofstream out(tracePath);
+            if (!out) {
+                std::cerr << "Could not write trace to " << tracePath << std::endl;
+                return;
+            }
+            writeTrace(out);
+        });
+    }
+
+    /**
+       Opens the hardware performance counters for every thread's scopes.
+       Each scope then costs two extra system calls, so leave this off
+       unless the counters are wanted. Falls back to timing only, with a
+       note in printData(), where perf_event_open is unavailable (no PMU in
+       the VM, a seccomp filter, or perf_event_paranoid above 2).
+       @return whether the counters could be opened on the calling thread
+    */
+    inline static bool enableCounters()
+    {
+        ThreadTotals& totals = localTotals ? *localTotals : registerThread();
+        modes.fetch_or(COUNTING);
+        if (!openCounters(totals)) {
+            modes.fetch_and(~unsigned(COUNTING));
+            return false;
+        }
+        return true;
+    }
+
+    /**
+       Records, per zone, the heap allocations made during each scope and
+       the peak of the bytes it kept live, as seen by the global operator
+       new/delete and lodepng's allocators (see allocation.h). Costs a few
+       thread-local reads per scope. Call before starting worker threads.
+    */
+    inline static void enableMemory()
+    {
+        enableAllocationTracking();
+        modes.fetch_or(TRACKING_MEMORY);
+    }
+
+    /**
+       Writes the recorded scopes as Chrome trace-event JSON. Only call once
+       the threads being traced have finished or are idle.
+    */
+    inline static void writeTrace(std::ostream& out)
+    {
+        double const usPerTick = millisecondsPerTick() * 1000;
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        char const* separator = "\n";
+        for (auto const& thread : threads) {
+            out << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                << thread->id << ",\"args\":{\"name\":\"thread " << thread->id << "\"}}";
+            separator = ",\n";
+
+            uint64_t const count = thread->traceCount.load(std::memory_order_acquire);
+            uint64_t const first = count > traceCapacity ? count - traceCapacity : 0;
+            for (uint64_t i = first; i < count; i++) {
+                TraceEvent const& event = thread->trace[i % traceCapacity];
+                out << separator << "{\"name\":\"" << jsonEscape(zoneNames[event.zone])
+                    << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->id << std::fixed
+                    << std::setprecision(3)
+                    << ",\"ts\":" << (event.startTicks - m_TickBase) * usPerTick
+                    << ",\"dur\":" << (event.endTicks - event.startTicks) * usPerTick << "}";
+            }
+        }
+        out << "\n]}" << std::endl;
+    }
 
 private:
+    /**
+       Calibrates ticks against the steady clock over the whole run.
+    */
+    inline static double millisecondsPerTick()
+    {
+        uint64_t const ticks = readTicks() - m_TickBase;
+        double const milliseconds
+            = std::chrono::duration<double, std::milli>(Clock::now() - m_ClockBase).count();
+        return ticks > 0 ? milliseconds / ticks : 0;
+    }
+
+    /**
+       Formats a duration with three significant digits in ns, us, ms or s.
+    */
+    inline static std::string formatDuration(double milliseconds)
+    {
+        char const* unit = "ms";
+        double value = milliseconds;
+        if (milliseconds >= 1000) {
+            value = milliseconds / 1000;
+            unit = "s";
+        } else if (milliseconds < 1e-3) {
+            value = milliseconds * 1e6;
+            unit = "ns";
+        } else if (milliseconds < 1) {
+            value = milliseconds * 1e3;
+            unit = "us";
+        }
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(value < 10 ? 2 : value < 100 ? 1 : 0) << value
+            << ' ' << unit;
+        return out.str();
+    }
+
+    /**
+       Prints, per zone, instructions per cycle and every counted event per
+       cell (for scopes given a cell count) or per call. Nested scopes
+       include the system calls that read their children's counters.
+    */
+    inline static void printCounters(std::ostream& out,
+        size_t maxLabelSize, std::vector<std::unique_ptr<Histogram>> const& merged)
+    {
+        if (!countersError.empty()) {
+            out << "hardware counters unavailable: " << countersError << std::endl;
+            return;
+        }
+        unsigned const events = countedEvents.load();
+        if (events == 0) {
+            return;
+        }
+
+        out << std::left << std::setw(maxLabelSize) << "counters" << "  " << std::right
+                  << std::setw(6) << "IPC" << std::setw(6) << "per";
+        for (int event = 0; event < PerfCounters::EVENTS; event++) {
+            out << std::setw(15) << PerfCounters::eventName(event);
+        }
+        out << '\n';
+
+        for (size_t zone = 0; zone < zoneNames.size(); zone++) {
+            PerfCounters::Counts sums {};
+            uint64_t items = 0;
+            for (auto const& totals : threads) {
+                if (ZoneCounters const* counters = totals->counterTotals.load(std::memory_order_acquire)) {
+                    for (int event = 0; event < PerfCounters::EVENTS; event++) {
+                        sums[event] += counters[zone].events[event].load(std::memory_order_relaxed);
+                    }
+                    items += counters[zone].items.load(std::memory_order_relaxed);
+                }
+            }
+            if (sums[PerfCounters::CYCLES] == 0) {
+                continue;
+            }
+
+            uint64_t const units = items ? items : merged[zone]->count();
+            double const ipc = double(sums[PerfCounters::INSTRUCTIONS]) / sums[PerfCounters::CYCLES];
+            out << std::left << std::setw(maxLabelSize) << zoneNames[zone] << ": "
+                      << std::right << std::fixed << std::setprecision(2) << std::setw(6) << ipc
+                      << std::setw(6) << (items ? "cell" : "call");
+            for (int event = 0; event < PerfCounters::EVENTS; event++) {
+                if (events & (1u << event)) {
+                    out << std::setw(15) << double(sums[event]) / units;
+                } else {
+                    out << std::setw(15) << "n/a";
+                }
+            }
+            out << '\n';
+        }
+        out << std::string(maxLabelSize + 89, '-') << std::endl;
+    }
+
+    /**
+       Prints, per zone, allocations and bytes allocated per call and the
+       largest peak of live bytes a single call reached, then the peak and
+       current resident set size of the process. A nested scope's memory is
+       included in its parents'.
+    */
+    inline static void printMemory(std::ostream& out,
+        size_t maxLabelSize, std::vector<std::unique_ptr<Histogram>> const& merged)
+    {
+        if (modes.load() & TRACKING_MEMORY) {
+            out << std::left << std::setw(maxLabelSize) << "memory" << "  " << std::right
+                      << std::setw(14) << "allocs/call" << std::setw(14) << "bytes/call"
+                      << std::setw(14) << "peak live" << '\n';
+
+            for (size_t zone = 0; zone < zoneNames.size(); zone++) {
+                uint64_t const calls = merged[zone]->count();
+                if (calls == 0) {
+                    continue;
+                }
+                uint64_t allocations = 0;
+                uint64_t bytes = 0;
+                uint64_t peak = 0;
+                for (auto const& totals : threads) {
+                    if (ZoneMemory const* memory = totals->memoryTotals.load(std::memory_order_acquire)) {
+                        allocations += memory[zone].allocations.load(std::memory_order_relaxed);
+                        bytes += memory[zone].bytes.load(std::memory_order_relaxed);
+                        peak = std::max(peak, memory[zone].peak.load(std::memory_order_relaxed));
+                    }
+                }
+                out << std::left << std::setw(maxLabelSize) << zoneNames[zone] << ": "
+                          << std::right << std::fixed << std::setprecision(1) << std::setw(14)
+                          << double(allocations) / calls << std::setw(14)
+                          << formatBytes(double(bytes) / calls) << std::setw(14)
+                          << formatBytes(double(peak)) << '\n';
+            }
+        }
+
+        if (size_t const peakRss = peakResidentBytes()) {
+            out << "peak RSS " << formatBytes(double(peakRss)) << ", current RSS "
+                      << formatBytes(double(residentBytes())) << '\n';
+        }
+        out << std::string(maxLabelSize + 72, '-') << std::endl;
+    }
+
+    /**
+       Formats a byte count with three significant digits in B, KiB, MiB or GiB.
+    */
+    inline static std::string formatBytes(double bytes)
+    {
+        char const* const units[] = { "B", "KiB", "MiB", "GiB" };
+        int unit = 0;
+        while (bytes >= 1024 && unit < 3) {
+            bytes /= 1024;
+            unit++;
+        }
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(unit == 0 || bytes >= 100 ? 0 : bytes >= 10 ? 1 : 2)
+            << bytes << ' ' << units[unit];
+        return out.str();
+    }
+
+    inline static std::string jsonEscape(std::string const& text)
+    {
+        std::string escaped;
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    [[gnu::noinline, gnu::cold]] static ThreadTotals& registerThread()
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        auto totals = std::make_unique<ThreadTotals>();
+        totals->id = static_cast<uint32_t>(threads.size());
+        for (size_t zone = 0; zone < zoneNames.size(); zone++) {
+            totals->zones[zone].store(new Histogram(), std::memory_order_relaxed);
+        }
+        threads.push_back(std::move(totals));
+        localTotals = threads.back().get();
+        return *localTotals;
+    }
+
+    /**
+       Opens the calling thread's counters once; later calls return the
+       outcome of the first attempt.
+    */
+    inline static bool openCounters(ThreadTotals& totals)
+    {
+        if (!totals.counters) {
+            totals.counters = std::make_unique<PerfCounters>();
+            if (!totals.counters->open()) {
+                std::lock_guard<std::mutex> lock(registryMutex);
+                countersError = totals.counters->error();
+                return false;
+            }
+            unsigned events = 0;
+            for (int event = 0; event < PerfCounters::EVENTS; event++) {
+                events |= totals.counters->hasEvent(event) ? 1u << event : 0;
+            }
+            countedEvents.fetch_or(events);
+            totals.counterTotals.store(new ZoneCounters[MAX_ZONES], std::memory_order_release);
+        }
+        return totals.counters->isOpen();
+    }
+
+    inline bool startCounters()
+    {
+        ThreadTotals& totals = localTotals ? *localTotals : registerThread();
+        if (!openCounters(totals)) {
+            return false;
+        }
+        m_StartCounts = totals.counters->read();
+        return true;
+    }
+
+    inline void startMemory()
+    {
+        ThreadTotals& totals = localTotals ? *localTotals : registerThread();
+        if (!totals.memoryTotals.load(std::memory_order_relaxed)) {
+            totals.memoryTotals.store(new ZoneMemory[MAX_ZONES], std::memory_order_release);
+        }
+        // Restarts the thread's high-water mark for this scope; Stop()
+        // restores the enclosing scope's.
+        AllocationCounters& allocations = threadAllocations();
+        m_StartMemory = allocations;
+        allocations.peak = allocations.live;
+    }
+
+    inline void stopMemory(ThreadTotals& totals)
+    {
+        AllocationCounters& allocations = threadAllocations();
+        ZoneMemory& memory = totals.memoryTotals.load(std::memory_order_relaxed)[m_Zone];
+        accumulate(memory.allocations, allocations.allocations - m_StartMemory.allocations);
+        accumulate(memory.bytes, allocations.bytes - m_StartMemory.bytes);
+        uint64_t const peak = static_cast<uint64_t>(
+            std::max<int64_t>(0, allocations.peak - m_StartMemory.live));
+        if (peak > memory.peak.load(std::memory_order_relaxed)) {
+            memory.peak.store(peak, std::memory_order_relaxed);
+        }
+        allocations.peak = std::max(allocations.peak, m_StartMemory.peak);
+    }
+
+    // adds to a counter that only the calling thread writes
+    inline static void accumulate(std::atomic<uint64_t>& counter, uint64_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    inline static void record(ThreadTotals& totals, Zone zone, uint64_t start, uint64_t end)
+    {
+        if (!totals.trace) {
+            totals.trace = std::make_unique<TraceEvent[]>(traceCapacity);
+        }
+        uint64_t const count = totals.traceCount.load(std::memory_order_relaxed);
+        totals.trace[count % traceCapacity] = { start, end, zone };
+        totals.traceCount.store(count + 1, std::memory_order_release);
+    }
+
+    /**
+       Starts what the modes record besides the time, which no scope does
+       by default, so it stays out of the inlined constructor.
+    */
+    [[gnu::noinline]] void startModes()
+    {
+        if (m_Modes & TRACKING_MEMORY) {
+            startMemory();
+        }
+        if ((m_Modes & COUNTING) && !startCounters()) {
+            m_Modes &= ~COUNTING;
+        }
+    }
+
+    [[gnu::noinline]] void stopModes(ThreadTotals& totals, uint64_t endTicks)
+    {
+        if (m_Modes & TRACKING_MEMORY) {
+            stopMemory(totals);
+        }
+        if (m_Modes & TRACING) {
+            record(totals, m_Zone, m_StartTicks, endTicks);
+        }
+        if (m_Modes & COUNTING) {
+            PerfCounters::Counts const endCounts = totals.counters->read();
+            ZoneCounters& counters = totals.counterTotals.load(std::memory_order_relaxed)[m_Zone];
+            for (int event = 0; event < PerfCounters::EVENTS; event++) {
+                accumulate(counters.events[event], endCounts[event] - m_StartCounts[event]);
+            }
+            accumulate(counters.items, m_Items);
+        }
+    }
+
+    /**
+       Buckets the waiting scopes of the calling thread into its histograms.
+       Runs once every PENDING scopes, so it is kept out of line and the
+       inlined Stop() is only the store.
+    */
+    [[gnu::noinline, gnu::cold]] static void flush(ThreadTotals& totals, uint32_t pending)
+    {
+        for (uint32_t i = 0; i < pending; i++) {
+            uint64_t const scope = totals.pending[i].load(std::memory_order_relaxed);
+            totals.zones[scope >> ZONE_SHIFT].load(std::memory_order_relaxed)->record(
+                scope & MAX_PENDING_TICKS);
+        }
+    }
+
     inline void Stop()
     {
-        auto const endTimepoint = std::chrono::high_resolution_clock::now();
-        auto const duration
-            = std::chrono::duration<double, std::milli>(endTimepoint - m_StartTimepoint).count();
+        uint64_t const endTicks = readTicks();
+        uint64_t const elapsed = endTicks - m_StartTicks;
 
-        if (label.size() > maxLabelSize) {
-            maxLabelSize = label.size();
+        ThreadTotals& totals = localTotals ? *localTotals : registerThread();
+        if (m_Modes != 0) {
+            stopModes(totals, endTicks);
         }
 
-        data[label] += duration;
+        uint32_t pending = totals.pendingCount.load(std::memory_order_relaxed);
+        totals.pending[pending].store(
+            uint64_t(m_Zone) << ZONE_SHIFT | std::min(elapsed, MAX_PENDING_TICKS),
+            std::memory_order_relaxed);
+        if (++pending == PENDING) {
+            flush(totals, pending);
+            pending = 0;
+        }
+        totals.pendingCount.store(pending, std::memory_order_release);
     }
 };
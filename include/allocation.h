@@ -0,0 +1,57 @@
+#ifndef ALLOCATION_H
+#define ALLOCATION_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+   Heap usage of one thread, kept by the global operator new/delete and the
+   lodepng allocators in allocation.cpp once enableAllocationTracking() has
+   been called. Sizes are the usable sizes malloc reports, so they include
+   its rounding but not its headers. A block freed by another thread than
+   the one that allocated it, or allocated before tracking began, lowers the
+   freeing thread's live bytes, which can then go negative. Without glibc,
+   bytes are the requested sizes and live and peak stay 0.
+*/
+struct AllocationCounters {
+  uint64_t allocations = 0; // calls to new, malloc and realloc
+  uint64_t bytes = 0;       // bytes handed out, never decreases
+  int64_t live = 0;         // bytes allocated minus bytes freed
+  int64_t peak = 0;         // high-water mark of live
+};
+
+/**
+   Starts counting allocations in every thread. Until then the allocators
+   check one relaxed flag and go straight to malloc and free.
+*/
+void enableAllocationTracking();
+
+/**
+   Returns the counters of the calling thread. The Timer resets peak to
+   live at the start of a scope to measure that scope's high-water mark.
+*/
+AllocationCounters &threadAllocations();
+
+/**
+   Returns the peak resident set size of this process (VmHWM in
+   /proc/self/status), or 0 where that is not available.
+*/
+size_t peakResidentBytes();
+
+/**
+   Returns the current resident set size of this process (VmRSS in
+   /proc/self/status), or 0 where that is not available.
+*/
+size_t residentBytes();
+
+/**
+   lodepng's allocator. The build defines LODEPNG_NO_COMPILE_ALLOCATORS, so
+   lodepng calls these instead of malloc, realloc and free, and buffers it
+   returns, such as the output of lodepng_encode, go back through
+   lodepng_free.
+*/
+void *lodepng_malloc(size_t size);
+void *lodepng_realloc(void *ptr, size_t new_size);
+void lodepng_free(void *ptr);
+
+#endif
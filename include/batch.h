@@ -0,0 +1,72 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "generator.h"
+#include "maze.h"
+
+/**
+   Settings for generating many mazes in one process.
+*/
+struct BatchOptions {
+  int count = 1000;
+  int minSize = 51;  // smallest width/height in pixels
+  int maxSize = 501; // largest width/height in pixels
+  uint64_t seedBase = 1;
+  Algorithm algorithm = Algorithm::BACKTRACKER;
+  bool solve = true;
+  int scale = 1;         // output pixels per grid cell along each axis
+  RenderStyle style = RenderStyle::GRAY;
+  int threads = 0;       // 0 uses every hardware thread
+  std::string outputDir; // empty keeps the PNGs in memory only
+};
+
+/**
+   Time and volume spent in one pipeline stage, summed over all workers.
+*/
+struct StageTotals {
+  double seconds = 0;
+  uint64_t items = 0; // cells for grid stages, bytes for PNG stages
+};
+
+struct BatchStats {
+  Algorithm algorithm = Algorithm::BACKTRACKER;
+  int mazes = 0;
+  int threads = 0;
+  double wallSeconds = 0;
+  uint64_t cells = 0;
+  StageTotals generate;
+  StageTotals solve;
+  StageTotals render;
+  StageTotals encode;
+  StageTotals write;
+
+  // per-maze latency from grid setup to the encoded PNG
+  double latencyP50 = 0;
+  double latencyP90 = 0;
+  double latencyP99 = 0;
+  double latencyP999 = 0;
+  double latencyMax = 0;
+};
+
+/**
+   Generates, solves and encodes options.count mazes on a pool of worker
+   threads. Maze i is seeded with options.seedBase + i, so its size and
+   layout do not depend on the thread count. Each worker keeps its grid,
+   generator stack, solver stack, picture and PNG buffer across jobs.
+   @throws std::runtime_error if the options are invalid (including a size
+   range without an odd size), a std::rand based
+   algorithm is asked to run on several threads, or a maze cannot be
+   written
+*/
+BatchStats runBatch(const BatchOptions &options);
+
+/**
+   Prints the throughput of every stage of a batch run.
+*/
+void printBatchStats(const BatchStats &stats, std::ostream &out = std::cout);
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <cstdint>
+#include <string>
+
+#include "AldousBroderWilson.h"
+#include "Grid.h"
+#include "GrowingTree.h"
+#include "HuntAndKill.h"
+
+enum class Algorithm {
+  CELL_STACK,    // generateNewMazeCellStack
+  RECURSIVE,     // generateNewMazeCellRecursive
+  BACKTRACKER,   // GrowingTree<NewestCell>
+  PRIM,          // GrowingTree<RandomCell>
+  GROWING_TREE,  // GrowingTree<MixedCell<50>>
+  HUNT_AND_KILL, // HuntAndKill
+  UNIFORM        // AldousBroderWilson at coverage 0, Wilson's algorithm
+};
+
+/**
+   Returns the command-line name of an algorithm.
+*/
+const char *algorithmName(Algorithm algorithm);
+
+/**
+   Looks up an algorithm by its command-line name.
+   @throws std::runtime_error if no algorithm has that name
+*/
+Algorithm parseAlgorithm(const std::string &name);
+
+/**
+   Returns the command-line names of all algorithms, separated by '|'.
+*/
+std::string algorithmNames();
+
+/**
+   Runs one of the maze generators. Keeps an instance of every generator so
+   their buffers are reused when one MazeGenerator makes many mazes.
+
+   CELL_STACK and RECURSIVE draw from std::rand, so seed() reseeds the
+   process-wide generator for them and they must not run concurrently.
+   std::srand takes 32 bits, so their seed is the two halves of the 64-bit
+   seed XORed together.
+*/
+class MazeGenerator {
+public:
+  explicit MazeGenerator(Algorithm algorithm = Algorithm::BACKTRACKER)
+      : _algorithm(algorithm) {}
+
+  Algorithm algorithm() const { return _algorithm; }
+  void setAlgorithm(Algorithm algorithm) { _algorithm = algorithm; }
+
+  /**
+     Seeds the generator of the current algorithm with all 64 bits of
+     seed, through a std::seed_seq of its two halves.
+  */
+  void seed(uint64_t seed);
+
+  /**
+     Carves a maze into a grid prepared by initializeMaze.
+  */
+  void generate(Grid &grid, int startX, int startY);
+
+private:
+  Algorithm _algorithm;
+  Backtracker _backtracker;
+  PrimLike _prim;
+  GrowingTree<MixedCell<50>> _growingTree;
+  HuntAndKill<> _huntAndKill;
+  AldousBroderWilson<> _uniform;
+};
+
+#endif
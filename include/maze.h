@@ -0,0 +1,84 @@
+#ifndef MAZE_H
+#define MAZE_H
+
+#include <utility>
+#include <vector>
+
+#include "Color_Types.h"
+#include "Grid.h"
+
+class Picture;
+
+// how renderMaze() and the command line color a maze
+enum class RenderStyle { GRAY, DISTANCE };
+
+// returns random even number between 2 and maxWidth - 1;
+int getStart(int max);
+
+/**
+   Fills the grid with unvisited cells separated by walls and surrounds it
+   with a border of visited cells, which acts as a sentinel for the
+   generators.
+   @throws std::runtime_error if the grid is smaller than 5x5
+*/
+void initializeMaze(Grid &grid);
+
+/**
+   Carves a maze with an iterative recursive-backtracker.
+*/
+void generateNewMazeCellStack(int startX, int startY, Grid &grid);
+
+void generateNewMazeCellRecursive(int currX, int currY, Grid &grid);
+
+/**
+   Marks the route from the entrance to the exit as PATH and every explored
+   dead end as WRONG_PATH.
+*/
+void solveMaze(Grid &grid);
+
+/**
+   Solves like solveMaze(grid) without timing, reusing the given stack
+   across calls. Safe to call concurrently on different grids.
+*/
+void solveMaze(Grid &grid, std::vector<std::pair<int, int>> &cellStack);
+
+void removeBorder(Grid &grid);
+
+/**
+   Draws the grid into a picture, one scale x scale block per grid cell.
+   Reuses the picture's pixel buffer when it is large enough.
+   @throws std::length_error if the picture would be more than INT_MAX
+   pixels across
+*/
+void renderMaze(const Grid &grid, Picture &pic, int scale);
+
+/**
+   Draws a width x height part of what renderMaze() would draw, starting
+   at pixel (left, top) of the full picture, without drawing the rest.
+   @throws std::out_of_range if the region does not fit the full picture
+*/
+void renderMazeRegion(const Grid &grid, Picture &pic, int scale, int left,
+                      int top, int width, int height);
+
+/**
+   Builds the gradient renderMazeDistance() draws with: size colors along
+   an OKLCH rainbow from clrspc::get_rainbow_colors. Build it once and
+   reuse it; the renderer only indexes it.
+   @throws std::domain_error if size is less than 2
+*/
+std::vector<clrspc::Rgb8> distancePalette(int size = 4096);
+
+/**
+   Draws the grid like renderMaze(), but colors every open pixel by its
+   breadth-first distance from the entrance, stretched over the whole
+   palette, whether or not the grid is solved. Walls stay black and the
+   border gray.
+   @throws std::invalid_argument if the palette is empty
+   @throws std::length_error like renderMaze()
+*/
+void renderMazeDistance(const Grid &grid, Picture &pic, int scale,
+                        const std::vector<clrspc::Rgb8> &palette);
+
+void createPicture(const Grid &grid);
+
+#endif
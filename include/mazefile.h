@@ -0,0 +1,150 @@
+#ifndef MAZEFILE_H
+#define MAZEFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Grid.h"
+#include "generator.h"
+
+/**
+   The .maze file format, version 1. All integers are little-endian.
+
+     offset  size  field
+          0     8  magic "MAZEGRID"
+          8     4  version, 1
+         12     4  offset of the cell data, a multiple of 4096
+         16     4  width in grid pixels, walls included (odd, >= 5)
+         20     4  height in grid pixels
+         24     8  seed the maze was generated with
+         32    24  algorithm name as on the command line, NUL padded
+         56     8  size of the cell data in bytes
+         64        zero up to the cell data
+
+   The cell data holds 2 bits per maze cell, four cells to a byte with the
+   first in the low bits. Cells are numbered row by row over the lattice of
+   (width - 3) / 2 by (height - 3) / 2 cells; cell (cx, cy) is grid pixel
+   (2 + 2 cx, 2 + 2 cy). Its low bit is set when the passage to its east
+   is open and its high bit when the passage to its south is. Everything
+   else follows from initializeMaze(): the border, the entrance at (1, 2)
+   and the exit at (width - 2, height - 3). Solutions are not stored.
+
+   Starting the cell data on a page boundary lets a reader map the file and
+   use the cells in place.
+*/
+const size_t MAZE_FILE_DATA_OFFSET = 4096;
+
+struct MazeFileInfo {
+  int width = 0;
+  int height = 0;
+  uint64_t seed = 0;
+  Algorithm algorithm = Algorithm::BACKTRACKER;
+};
+
+/**
+   Writes the walls of a generated grid as a .maze file.
+   @param filename the file to create or replace
+   @param grid a grid carved by one of the generators, solved or not
+   @param seed the seed to record
+   @param algorithm the algorithm to record
+   @throws std::invalid_argument if the grid has an even or too small side
+   @throws std::runtime_error if the file cannot be written
+*/
+void writeMazeFile(const std::string &filename, const Grid &grid,
+                   uint64_t seed, Algorithm algorithm);
+
+/**
+   A read-only view of the cell data of a .maze file, answering queries in
+   grid coordinates straight from the packed bits. Copies are cheap and
+   stay valid as long as the MazeFile they came from.
+*/
+class MazeView {
+public:
+  MazeView() : _cells(nullptr), _width(0), _height(0), _columns(0) {}
+
+  MazeView(const uint8_t *cells, int width, int height)
+      : _cells(cells), _width(width), _height(height),
+        _columns((width - 3) / 2) {}
+
+  int width() const { return _width; }
+  int height() const { return _height; }
+
+  // the lattice of maze cells
+  int columns() const { return _columns; }
+  int rows() const { return (_height - 3) / 2; }
+
+  /**
+     Returns whether the passage east of maze cell (cx, cy) is open,
+     without a bounds check.
+  */
+  bool eastOpen(int cx, int cy) const { return bits(cx, cy) & 1; }
+
+  /**
+     Returns whether the passage south of maze cell (cx, cy) is open,
+     without a bounds check.
+  */
+  bool southOpen(int cx, int cy) const { return bits(cx, cy) & 2; }
+
+  /**
+     Yields the state initializeMaze() and a generator leave at the given
+     grid position: VISITED where open, UNVISITED for walls.
+     @throws std::out_of_range if the point is not in the grid
+  */
+  cellState at(int x, int y) const;
+
+  /**
+     Unpacks the whole maze into a grid, as generated and not yet solved.
+  */
+  void toGrid(Grid &grid) const;
+
+  const uint8_t *data() const { return _cells; }
+
+private:
+  unsigned bits(int cx, int cy) const {
+    const size_t cell = size_t(cy) * _columns + cx;
+    return _cells[cell / 4] >> (2 * (cell % 4)) & 3;
+  }
+
+  const uint8_t *_cells;
+  int _width;
+  int _height;
+  int _columns;
+};
+
+/**
+   An open .maze file. Where mmap is available the file is mapped
+   read-only and the view points into the mapping, so opening costs the
+   same for any size and pages load as they are used; elsewhere the file
+   is read into memory.
+*/
+class MazeFile {
+public:
+  /**
+     Opens and validates a .maze file.
+     @throws std::runtime_error if the file cannot be read or is not a
+     version 1 .maze file
+  */
+  explicit MazeFile(const std::string &filename);
+  ~MazeFile();
+
+  MazeFile(MazeFile &&other) noexcept;
+  MazeFile &operator=(MazeFile &&other) noexcept;
+  MazeFile(const MazeFile &) = delete;
+  MazeFile &operator=(const MazeFile &) = delete;
+
+  const MazeFileInfo &info() const { return _info; }
+  MazeView view() const { return _view; }
+
+private:
+  void close();
+
+  MazeFileInfo _info;
+  MazeView _view;
+  void *_mapping = nullptr; // the whole file when mapped
+  size_t _mappingSize = 0;
+  std::vector<uint8_t> _contents; // the whole file when not
+};
+
+#endif
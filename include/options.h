@@ -0,0 +1,51 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "generator.h"
+#include "maze.h"
+
+enum class OutputFormat { PNG, MAZE, TILES };
+
+/**
+   Settings of one run of the maze program, filled from the command line.
+*/
+struct Options {
+  int width = 101;
+  int height = 101;
+  Algorithm algorithm = Algorithm::BACKTRACKER;
+  bool solve = true; // --solver dfs|none
+  uint64_t seed = 0;
+  bool hasSeed = false; // otherwise seeded from the clock
+  int threads = 0; // batch or tile workers, 0 uses every hardware thread
+  int scale = 1;        // output pixels per grid cell along each axis
+  RenderStyle style = RenderStyle::GRAY; // --color gray|distance
+  std::string output;   // file, or directory in batch mode
+  std::string input;    // .maze file to load instead of generating
+  GridStorage storage = GridStorage::MEMORY; // --storage memory|mapped
+  OutputFormat format = OutputFormat::PNG;
+  bool noOutput = false;
+  bool timer = false;
+  bool counters = false; // hardware counters in the --timer report
+  bool memory = false;   // heap usage per stage in the --timer report
+  std::string trace; // Chrome trace-event JSON file, empty disables tracing
+
+  int batchCount = 0; // > 0 selects batch mode
+  int minSize = 51;
+  int maxSize = 501;
+
+  bool help = false;
+};
+
+/**
+   Parses the command line.
+   @throws std::runtime_error on an unknown option or an invalid value
+*/
+Options parseOptions(int argc, char *argv[]);
+
+void printUsage(const char *program, std::ostream &out = std::cout);
+
+#endif
@@ -1,13 +1,53 @@
 #ifndef PICTURE_H
 #define PICTURE_H
 
+#include <cstddef>
+#include <functional>
+#include <span>
 #include <string>
 #include <vector>
 
+#include "Color_Types.h"
 #include "lodepng.h"
 
 using namespace std;
 
+/**
+   A PNG file encoded in memory. Owns the buffer the encoder wrote, so
+   returning one from Picture::encode() copies nothing. Move-only.
+*/
+class PngData {
+public:
+  PngData() : _data(nullptr), _size(0) {}
+  ~PngData();
+
+  PngData(PngData &&other) noexcept;
+  PngData &operator=(PngData &&other) noexcept;
+  PngData(const PngData &) = delete;
+  PngData &operator=(const PngData &) = delete;
+
+  const unsigned char *data() const { return _data; }
+  size_t size() const { return _size; }
+  bool empty() const { return _size == 0; }
+
+  span<const unsigned char> bytes() const { return {_data, _size}; }
+  const unsigned char *begin() const { return _data; }
+  const unsigned char *end() const { return _data + _size; }
+
+private:
+  friend class Picture;
+  PngData(unsigned char *data, size_t size) : _data(data), _size(size) {}
+
+  unsigned char *_data; // allocated by lodepng
+  size_t _size;
+};
+
+/**
+   Receives the bytes of an encoded PNG file, e.g. to send them on a
+   socket or append them to a response.
+*/
+using PngWriter = function<void(span<const unsigned char> bytes)>;
+
 class Picture {
 public:
   /**
@@ -57,6 +97,65 @@ public:
   */
   void save(string filename) const;
 
+  /**
+     Encodes this picture as PNG into the given buffer, replacing its
+     contents but keeping its capacity, so a buffer reused across calls
+     is only reallocated when a file outgrows it. lodepng encodes into a
+     buffer of its own, so this copies the file once; encode() and
+     encode(PngWriter) do not.
+     @param out the buffer receiving the PNG file contents
+  */
+  void encode(vector<unsigned char> &out) const;
+
+  /**
+     Encodes this picture as PNG and hands the file to a writer, straight
+     from the encoder's buffer.
+     @param write called once with the whole file
+  */
+  void encode(const PngWriter &write) const;
+
+  /**
+     Encodes this picture as PNG into a buffer of its own.
+     @return the PNG file contents
+  */
+  PngData encode() const;
+
+  /**
+     Resizes this picture and fills it with a single color, reusing the
+     existing pixel buffer when it is large enough.
+     @param width the new width
+     @param height the new height
+     @param red the red value of the pixels (between 0 and 255)
+     @param green the green value of the pixels (between 0 and 255)
+     @param blue the blue value of the pixels (between 0 and 255)
+  */
+  void assign(int width, int height, int red = 255, int green = 255,
+              int blue = 255);
+
+  /**
+     Resizes this picture like assign(), but leaves the pixels as they are,
+     for callers that go on to write every one of them.
+     @param width the new width
+     @param height the new height
+  */
+  void resize(int width, int height);
+
+  /**
+     Makes room for a picture of the given size without changing this
+     picture, so that growing it up to that size through set(), add() or
+     the fills does not reallocate.
+     @param width the width to make room for
+     @param height the height to make room for
+  */
+  void reserve(int width, int height);
+
+  /**
+     Returns the number of pixels between the starts of two rows, which
+     may exceed width() once the picture has grown.
+     @return the row stride in pixels
+  */
+  int stride() const { return _stride; }
+
   /**
      Yields the red value at the given position.
      @param x the x-coordinate (column)
@@ -84,6 +183,15 @@ public:
   */
   int blue(int x, int y) const;
 
+  /**
+     Yields the color at the given position.
+     @param x the x-coordinate (column)
+     @param y the y-coordinate (row)
+     @return the color of the pixel, or black if the given point is not in
+     the picture.
+  */
+  clrspc::Rgb8 pixel(int x, int y) const;
+
   /**
      Sets a pixel to a given color, expanding
      the picture if necessary.
@@ -95,6 +203,61 @@ public:
   */
   void set(int x, int y, int red, int green, int blue);
 
+  void set(int x, int y, clrspc::Rgb8 color);
+
+  /**
+     Yields the pixels of a row as RGBA bytes, 4 per pixel, without a
+     bounds check. The pointer stays valid until the picture grows.
+     @param y the y-coordinate (row), between 0 and height() - 1
+     @return the first byte of the row
+  */
+  unsigned char *row(int y) { return _values.data() + 4 * size_t(y) * _stride; }
+
+  const unsigned char *row(int y) const {
+    return _values.data() + 4 * size_t(y) * _stride;
+  }
+
+  /**
+     Yields the pixels of a row as a span of 4 * width() RGBA bytes,
+     without a bounds check.
+     @param y the y-coordinate (row), between 0 and height() - 1
+  */
+  span<unsigned char> rowSpan(int y) { return {row(y), 4 * size_t(_width)}; }
+
+  span<const unsigned char> rowSpan(int y) const {
+    return {row(y), 4 * size_t(_width)};
+  }
+
+  /**
+     Sets a horizontal run of pixels to a given color, expanding the
+     picture if necessary. Pixels left of or above the picture are skipped.
+     @param x the x-coordinate (column) of the first pixel
+     @param y the y-coordinate (row)
+     @param length the number of pixels
+     @param red the red value of the pixels (between 0 and 255)
+     @param green the green value of the pixels (between 0 and 255)
+     @param blue the blue value of the pixels (between 0 and 255)
+  */
+  void fillSpan(int x, int y, int length, int red, int green, int blue);
+
+  void fillSpan(int x, int y, int length, clrspc::Rgb8 color);
+
+  /**
+     Sets a rectangle of pixels to a given color, expanding the picture if
+     necessary. Pixels left of or above the picture are skipped.
+     @param x the x-coordinate (column) of the top left corner
+     @param y the y-coordinate (row) of the top left corner
+     @param width the width of the rectangle
+     @param height the height of the rectangle
+     @param red the red value of the pixels (between 0 and 255)
+     @param green the green value of the pixels (between 0 and 255)
+     @param blue the blue value of the pixels (between 0 and 255)
+  */
+  void fillRect(int x, int y, int width, int height, int red, int green,
+                int blue);
+
+  void fillRect(int x, int y, int width, int height, clrspc::Rgb8 color);
+
   /**
      Yields the gray levels of all pixels of this image.
      @return a 2D array of gray values (between 0 and 255)
@@ -103,7 +266,9 @@ public:
 
   /**
      Adds a picture to this picture at a given position, expanding
-     the picture if necessary.
+     the picture if necessary. Copies the colors row by row, every pixel
+     opaque; the part left of or above this picture is skipped, and a
+     picture that lies wholly there changes nothing.
      @param other the picture to add
      @param x the x-coordinate (column) of the top left corner
      @param y the y-coordinate (row) of the top left corner
@@ -112,12 +277,38 @@ public:
 
   Picture bilinearResize(float factor) const;
 
+  /**
+     Scales this picture up by repeating every pixel, which keeps the hard
+     edges of a maze. Builds each output row once and copies it.
+     @param factor the output pixels per input pixel along each axis
+     @return the scaled picture
+     @throws std::invalid_argument if factor is less than 1
+  */
+  Picture scaleNearest(int factor) const;
+
+  /**
+     Scales this picture up by repeating every pixel xFactor times across
+     and yFactor times down.
+     @param xFactor the output pixels per input pixel horizontally
+     @param yFactor the output pixels per input pixel vertically
+     @return the scaled picture
+     @throws std::invalid_argument if a factor is less than 1
+  */
+  Picture scaleNearest(int xFactor, int yFactor) const;
+
 private:
   void ensure(int x, int y);
+  void reallocate(int stride, int rows);
+  void fillWhite(int left, int top, int right, int bottom);
+  void fillPixels(size_t begin, size_t end, clrspc::Rgb8 color);
+  const unsigned char *packed(vector<unsigned char> &scratch) const;
 
+  // rows of _stride pixels, of which the first _width of the first
+  // _height rows are the picture; the rest is spare capacity
   vector<unsigned char> _values;
   int _width;
   int _height;
+  int _stride;
 };
 
 #endif
@@ -0,0 +1,65 @@
+#ifndef TILEPYRAMID_H
+#define TILEPYRAMID_H
+
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+
+#include "Grid.h"
+
+/**
+   Settings of a tile pyramid export.
+*/
+struct TilePyramidOptions {
+  int tileSize = 256; // pixels along a tile side, a power of two
+  int scale = 1;      // full-resolution pixels per grid cell along each axis
+  int threads = 0;    // 0 uses every hardware thread
+};
+
+struct TilePyramidStats {
+  int levels = 0;
+  uint64_t tiles = 0;
+  uint64_t bytes = 0; // PNG bytes over all tiles
+};
+
+/**
+   Receives one encoded tile: the PNG of column col, row row of a level,
+   straight from the encoder's buffer and valid only during the call.
+   Called from several threads at once.
+*/
+using TileSink = std::function<void(int level, int col, int row,
+                                    std::span<const unsigned char> png)>;
+
+/**
+   Renders the maze as a Deep Zoom pyramid of PNG tiles, without overlap,
+   and hands every tile to the sink.
+
+   The top level, maxLevel = ceil(log2(max(width, height))), is the maze
+   as renderMaze() draws it at the given scale. Level L is level L + 1
+   halved by a 2x2 box filter, rounding its size up, down to a single
+   pixel at level 0. A tile at the top level is rendered straight from
+   the grid; every other tile is filtered from the four tiles below it.
+   So no more than a few tiles per thread are ever in memory, whatever the
+   size of the maze.
+
+   Workers take subtrees of the pyramid, render and encode them, and
+   filter the few levels above them on the calling thread.
+   @throws std::invalid_argument if the tile size is not a power of two of
+   at least 2 or the scale is less than 1
+   @throws whatever the sink throws, after the workers have stopped
+*/
+TilePyramidStats renderTilePyramid(const Grid &grid,
+                                   const TilePyramidOptions &options,
+                                   const TileSink &sink);
+
+/**
+   Writes a Deep Zoom pyramid as OpenSeadragon and other viewers read it:
+   the descriptor base + ".dzi" and the tiles as
+   base + "_files/<level>/<col>_<row>.png".
+   @throws std::runtime_error if a file cannot be written
+*/
+TilePyramidStats writeTilePyramid(const Grid &grid, const std::string &base,
+                                  const TilePyramidOptions &options);
+
+#endif
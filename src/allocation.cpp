@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <string>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "../include/allocation.h"
+
+namespace {
+
+thread_local AllocationCounters counters;
+std::atomic<bool> tracking(false);
+
+// Counts a block of the given requested size. Without glibc's
+// malloc_usable_size a free cannot tell how much it gives back, so only
+// allocations and requested bytes are kept there.
+inline void *track(void *ptr, size_t size) {
+  if (ptr && tracking.load(std::memory_order_relaxed)) {
+    counters.allocations++;
+#ifdef __GLIBC__
+    size = malloc_usable_size(ptr);
+    counters.live += size;
+    if (counters.live > counters.peak)
+      counters.peak = counters.live;
+#endif
+    counters.bytes += size;
+  }
+  return ptr;
+}
+
+inline void untrack([[maybe_unused]] void *ptr) {
+#ifdef __GLIBC__
+  if (ptr && tracking.load(std::memory_order_relaxed))
+    counters.live -= malloc_usable_size(ptr);
+#endif
+}
+
+void *allocate(size_t size) {
+  void *ptr = track(std::malloc(size ? size : 1), size);
+  if (!ptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void *allocate(size_t size, std::align_val_t alignment) {
+  void *ptr = nullptr;
+  const size_t align = std::max(static_cast<size_t>(alignment), sizeof(void *));
+  if (posix_memalign(&ptr, align, size ? size : 1) != 0)
+    throw std::bad_alloc();
+  return track(ptr, size);
+}
+
+void release(void *ptr) {
+  untrack(ptr);
+  std::free(ptr);
+}
+
+// reads a "Name:   123 kB" line of /proc/self/status
+size_t statusBytes(const char *name) {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  const size_t length = std::strlen(name);
+  while (std::getline(status, line)) {
+    if (line.compare(0, length, name) == 0 && line.size() > length &&
+        line[length] == ':')
+      return std::strtoull(line.c_str() + length + 1, nullptr, 10) * 1024;
+  }
+  return 0;
+}
+
+} // namespace
+
+
+void enableAllocationTracking() {
+  tracking.store(true, std::memory_order_relaxed);
+}
+
+AllocationCounters &threadAllocations() { return counters; }
+
+size_t peakResidentBytes() { return statusBytes("VmHWM"); }
+
+size_t residentBytes() { return statusBytes("VmRSS"); }
+
+
+// lodepng calls these instead of malloc when built with
+// LODEPNG_NO_COMPILE_ALLOCATORS, so PNG work shows up in the counters too
+void *lodepng_malloc(size_t size) { return track(std::malloc(size), size); }
+
+void *lodepng_realloc(void *ptr, size_t new_size) {
+#ifdef __GLIBC__
+  const bool tracked = ptr && tracking.load(std::memory_order_relaxed);
+  const int64_t oldSize = tracked ? malloc_usable_size(ptr) : 0;
+#else
+  const int64_t oldSize = 0;
+#endif
+  void *resized = std::realloc(ptr, new_size);
+  if (resized || new_size == 0)
+    counters.live -= oldSize;
+  return track(resized, new_size);
+}
+
+void lodepng_free(void *ptr) { release(ptr); }
+
+
+void *operator new(size_t size) { return allocate(size); }
+void *operator new[](size_t size) { return allocate(size); }
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  return track(std::malloc(size ? size : 1), size);
+}
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return track(std::malloc(size ? size : 1), size);
+}
+
+void *operator new(size_t size, std::align_val_t alignment) {
+  return allocate(size, alignment);
+}
+void *operator new[](size_t size, std::align_val_t alignment) {
+  return allocate(size, alignment);
+}
+
+void operator delete(void *ptr) noexcept { release(ptr); }
+void operator delete[](void *ptr) noexcept { release(ptr); }
+void operator delete(void *ptr, size_t) noexcept { release(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { release(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { release(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { release(ptr); }
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept {
+  release(ptr);
+}
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept {
+  release(ptr);
+}
@@ -0,0 +1,252 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <iomanip>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../include/Histogram.h"
+#include "../include/Timer.h"
+#include "../include/batch.h"
+#include "../include/lodepng.h"
+#include "../include/maze.h"
+#include "../include/picture.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+   Everything one worker thread needs for a job. The buffers live as long
+   as the worker, the encoded PNG's included, so once they have grown to
+   the largest maze a worker only allocates inside lodepng.
+*/
+struct Worker {
+  Grid grid;
+  MazeGenerator generator;
+  std::vector<std::pair<int, int>> solveStack;
+  Picture picture;
+  std::vector<unsigned char> png;
+  BatchStats stats;
+  std::unique_ptr<Histogram> latency = std::make_unique<Histogram>(); // ns
+};
+
+// returns a random odd number in [min, max], which must hold one
+int randomOddSize(std::mt19937 &rng, int min, int max) {
+  return std::uniform_int_distribution<int>(min / 2, (max - 1) / 2)(rng) * 2 +
+         1;
+}
+
+// returns a random even coordinate between 2 and size - 3
+int randomStart(std::mt19937 &rng, int size) {
+  return 2 + 2 * std::uniform_int_distribution<int>(0, (size - 5) / 2)(rng);
+}
+
+/**
+   Adds the time since `start` to a stage and restarts the clock.
+*/
+void lap(StageTotals &stage, Clock::time_point &start, uint64_t items) {
+  const Clock::time_point now = Clock::now();
+  stage.seconds += std::chrono::duration<double>(now - start).count();
+  stage.items += items;
+  start = now;
+}
+
+void runJob(Worker &worker, const BatchOptions &options,
+            const std::vector<clrspc::Rgb8> &palette, int job) {
+  const uint64_t seed = options.seedBase + job;
+  std::seed_seq sequence{uint32_t(seed), uint32_t(seed >> 32)};
+  std::mt19937 rng(sequence);
+  const int width = randomOddSize(rng, options.minSize, options.maxSize);
+  const int height = randomOddSize(rng, options.minSize, options.maxSize);
+  const int startX = randomStart(rng, width);
+  const int startY = randomStart(rng, height);
+  const uint64_t cells = uint64_t(width) * height;
+
+  TIMER_ZONE_ITEMS("batch job", cells);
+  const Clock::time_point jobStart = Clock::now();
+  Clock::time_point start = jobStart;
+
+  {
+    TIMER_ZONE_ITEMS("batch generate", cells);
+    worker.grid.assign(width, height, UNVISITED);
+    initializeMaze(worker.grid);
+    worker.generator.seed(rng());
+    worker.generator.generate(worker.grid, startX, startY);
+  }
+  lap(worker.stats.generate, start, cells);
+
+  if (options.solve) {
+    TIMER_ZONE_ITEMS("batch solve", cells);
+    solveMaze(worker.grid, worker.solveStack);
+    lap(worker.stats.solve, start, cells);
+  }
+
+  {
+    TIMER_ZONE_ITEMS("batch render", cells);
+    if (options.style == RenderStyle::DISTANCE)
+      renderMazeDistance(worker.grid, worker.picture, options.scale, palette);
+    else
+      renderMaze(worker.grid, worker.picture, options.scale);
+  }
+  lap(worker.stats.render, start, cells);
+
+  {
+    TIMER_ZONE_ITEMS("batch encode", cells);
+    worker.picture.encode(worker.png);
+  }
+  lap(worker.stats.encode, start, worker.png.size());
+
+  if (!options.outputDir.empty()) {
+    TIMER_ZONE("batch write");
+    const std::string filename =
+        options.outputDir + "/maze_" + std::to_string(job) + ".png";
+    unsigned error = lodepng_save_file(worker.png.data(), worker.png.size(),
+                                       filename.c_str());
+    if (error != 0)
+      throw std::runtime_error(lodepng_error_text(error));
+    lap(worker.stats.write, start, worker.png.size());
+  }
+
+  worker.latency->record(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(start - jobStart)
+          .count());
+  worker.stats.mazes++;
+  worker.stats.cells += cells;
+}
+
+void addStage(StageTotals &total, const StageTotals &part) {
+  total.seconds += part.seconds;
+  total.items += part.items;
+}
+
+void printStage(std::ostream &out, const char *name, const StageTotals &stage,
+                const BatchStats &stats, const char *unit) {
+  if (stage.seconds == 0)
+    return;
+
+  // per-thread rates; multiply by the thread count for the pool's capacity
+  out << std::left << std::setw(10) << name << std::right << std::fixed
+      << std::setprecision(1) << std::setw(12) << stage.seconds * 1e3
+      << " ms | " << std::setw(10) << stats.mazes / stage.seconds
+      << " mazes/s | " << std::setprecision(2) << std::setw(10)
+      << stage.items / stage.seconds / 1e6 << " M" << unit << "/s\n";
+}
+
+} // namespace
+
+
+BatchStats runBatch(const BatchOptions &options) {
+  if (options.count < 0)
+    throw std::runtime_error("Batch count must not be negative.");
+  if (options.minSize < 5 || options.maxSize < options.minSize)
+    throw std::runtime_error(
+        "Batch sizes must satisfy 5 <= minimum size <= maximum size.");
+  if ((options.minSize | 1) > options.maxSize)
+    throw std::runtime_error("Batch sizes must include an odd size.");
+
+  int threads = options.threads;
+  if (threads <= 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  threads = std::min(threads, std::max(options.count, 1));
+
+  const bool sharedRand = options.algorithm == Algorithm::CELL_STACK ||
+                          options.algorithm == Algorithm::RECURSIVE;
+  if (sharedRand && threads > 1)
+    throw std::runtime_error(std::string("The ") +
+                             algorithmName(options.algorithm) +
+                             " algorithm uses std::rand and cannot run on "
+                             "several threads.");
+
+  std::vector<Worker> workers(threads);
+  for (Worker &worker : workers)
+    worker.generator.setAlgorithm(options.algorithm);
+  // built once and shared, since it costs thousands of OKLCH conversions
+  const std::vector<clrspc::Rgb8> palette =
+      options.style == RenderStyle::DISTANCE ? distancePalette()
+                                             : std::vector<clrspc::Rgb8>();
+  std::atomic<int> nextJob(0);
+  std::exception_ptr failure;
+  std::mutex failureMutex;
+
+  auto work = [&](Worker &worker) {
+    try {
+      for (int job = nextJob++; job < options.count; job = nextJob++)
+        runJob(worker, options, palette, job);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(failureMutex);
+      if (!failure)
+        failure = std::current_exception();
+      nextJob = options.count; // stop handing out jobs
+    }
+  };
+
+  const Clock::time_point start = Clock::now();
+
+  std::vector<std::thread> pool;
+  for (int i = 1; i < threads; i++)
+    pool.emplace_back(work, std::ref(workers[i]));
+  work(workers[0]);
+  for (auto &thread : pool)
+    thread.join();
+
+  if (failure)
+    std::rethrow_exception(failure);
+
+  Histogram latency;
+  BatchStats stats;
+  stats.algorithm = options.algorithm;
+  stats.threads = threads;
+  stats.wallSeconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  for (const Worker &worker : workers) {
+    stats.mazes += worker.stats.mazes;
+    stats.cells += worker.stats.cells;
+    addStage(stats.generate, worker.stats.generate);
+    addStage(stats.solve, worker.stats.solve);
+    addStage(stats.render, worker.stats.render);
+    addStage(stats.encode, worker.stats.encode);
+    addStage(stats.write, worker.stats.write);
+    latency.merge(*worker.latency);
+  }
+  stats.latencyP50 = latency.percentile(50) * 1e-9;
+  stats.latencyP90 = latency.percentile(90) * 1e-9;
+  stats.latencyP99 = latency.percentile(99) * 1e-9;
+  stats.latencyP999 = latency.percentile(99.9) * 1e-9;
+  stats.latencyMax = latency.max() * 1e-9;
+  return stats;
+}
+
+
+void printBatchStats(const BatchStats &stats, std::ostream &out) {
+  const std::string border(62, '-');
+
+  out << border << '\n';
+  out << stats.mazes << " mazes, " << stats.cells << " cells on "
+      << stats.threads << " thread(s) with " << algorithmName(stats.algorithm)
+      << "\n";
+  out << "stage times are summed over threads; rates are per thread\n";
+  out << border << '\n';
+  printStage(out, "generate", stats.generate, stats, "cells");
+  printStage(out, "solve", stats.solve, stats, "cells");
+  printStage(out, "render", stats.render, stats, "cells");
+  printStage(out, "encode", stats.encode, stats, "B");
+  printStage(out, "write", stats.write, stats, "B");
+  out << border << '\n';
+  out << std::left << std::setw(10) << "total" << std::right << std::fixed
+      << std::setprecision(1) << std::setw(12) << stats.wallSeconds * 1e3
+      << " ms | " << std::setw(10) << stats.mazes / stats.wallSeconds
+      << " mazes/s | " << std::setprecision(2) << std::setw(10)
+      << stats.cells / stats.wallSeconds / 1e6 << " Mcells/s\n";
+  out << std::left << std::setw(10) << "latency" << std::right
+      << std::setprecision(3) << " p50 " << stats.latencyP50 * 1e3
+      << " ms | p90 " << stats.latencyP90 * 1e3 << " ms | p99 "
+      << stats.latencyP99 * 1e3 << " ms | p99.9 " << stats.latencyP999 * 1e3
+      << " ms | max " << stats.latencyMax * 1e3 << " ms\n";
+  out << border << std::endl;
+}
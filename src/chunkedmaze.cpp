@@ -0,0 +1,134 @@
+#include <random>
+#include <stdexcept>
+
+#include "../include/ChunkedMaze.h"
+#include "../include/GrowingTree.h"
+#include "../include/Random.h"
+#include "../include/maze.h"
+
+namespace {
+
+// domains of hashKey(), so edge and chunk keys never collide
+enum KeyKind : uint64_t { EAST_EDGE = 1, SOUTH_EDGE, CHUNK };
+
+// cell along an edge where it is open, 0 .. chunkCells - 1
+int edgeOpening(uint64_t seed, KeyKind edge, int64_t chunkX, int64_t chunkY,
+                int chunkCells) {
+  CounterRng rng(hashKey(seed, edge, chunkX, chunkY));
+  return boundedRandom(rng, chunkCells);
+}
+
+// floor(a / b) for b > 0
+int64_t floorDiv(int64_t a, int64_t b) {
+  return a / b - (a % b < 0);
+}
+
+} // namespace
+
+
+MazeChunk::MazeChunk(uint64_t seed, int64_t chunkX, int64_t chunkY,
+                     int chunkCells)
+    : _chunkX(chunkX), _chunkY(chunkY) {
+  if (chunkCells < 1)
+    throw std::invalid_argument("A chunk needs at least one cell.");
+
+  // the chunk plus the sentinel border
+  const int size = 2 * chunkCells + 3;
+  _grid.assign(size, size, UNVISITED);
+  initializeMaze(_grid);
+  _grid[_grid.index(1, 2)] = UNVISITED; // initializeMaze's entrance
+  _grid[_grid.index(size - 2, size - 3)] = UNVISITED; // and exit
+
+  // one generator per thread, so its active array is reused; reseeding a
+  // CounterRng costs nothing
+  thread_local GrowingTree<NewestCell, CounterRng> generator;
+  generator.rng().seed(hashKey(seed, CHUNK, chunkX, chunkY));
+  generator.generate(_grid, 2, 2);
+
+  const auto open = [&](int x, int y) { _grid[_grid.index(x, y)] = VISITED; };
+  open(1, 2 + 2 * edgeOpening(seed, EAST_EDGE, chunkX - 1, chunkY,
+                              chunkCells));
+  open(size - 2,
+       2 + 2 * edgeOpening(seed, EAST_EDGE, chunkX, chunkY, chunkCells));
+  open(2 + 2 * edgeOpening(seed, SOUTH_EDGE, chunkX, chunkY - 1, chunkCells),
+       1);
+  open(2 + 2 * edgeOpening(seed, SOUTH_EDGE, chunkX, chunkY, chunkCells),
+       size - 2);
+}
+
+
+size_t ChunkedMaze::KeyHash::operator()(const Key &key) const {
+  return hashKey(key.first, key.second);
+}
+
+
+ChunkedMaze::ChunkedMaze(uint64_t seed, int chunkCells, size_t cacheChunks)
+    : _seed(seed), _chunkCells(chunkCells), _capacity(cacheChunks) {
+  if (chunkCells < 1)
+    throw std::invalid_argument("A chunk needs at least one cell.");
+  if (cacheChunks < 1)
+    throw std::invalid_argument("The chunk cache needs room for a chunk.");
+  _index.reserve(cacheChunks);
+}
+
+
+std::shared_ptr<const MazeChunk> ChunkedMaze::getChunk(int64_t chunkX,
+                                                       int64_t chunkY) {
+  const Key key(chunkX, chunkY);
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto found = _index.find(key);
+    if (found != _index.end()) {
+      _lru.splice(_lru.begin(), _lru, found->second);
+      _hits++;
+      return *found->second;
+    }
+    _misses++;
+  }
+
+  // generated without the lock, so other threads keep reading the cache;
+  // if two threads miss the same chunk, both build it and one is kept
+  auto chunk = std::make_shared<const MazeChunk>(_seed, chunkX, chunkY,
+                                                 _chunkCells);
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto found = _index.find(key);
+  if (found != _index.end()) {
+    _lru.splice(_lru.begin(), _lru, found->second);
+    return *found->second;
+  }
+  if (_index.size() >= _capacity) {
+    const MazeChunk &oldest = *_lru.back();
+    _index.erase(Key(oldest.chunkX(), oldest.chunkY()));
+    _lru.pop_back();
+  }
+  _lru.push_front(chunk);
+  _index.emplace(key, _lru.begin());
+  return chunk;
+}
+
+
+cellState ChunkedMaze::at(int64_t x, int64_t y) {
+  const int64_t chunkX = floorDiv(x, chunkPitch());
+  const int64_t chunkY = floorDiv(y, chunkPitch());
+  return getChunk(chunkX, chunkY)
+      ->at(int(x - chunkX * chunkPitch()), int(y - chunkY * chunkPitch()));
+}
+
+
+size_t ChunkedMaze::cachedChunks() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _index.size();
+}
+
+
+uint64_t ChunkedMaze::hits() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _hits;
+}
+
+
+uint64_t ChunkedMaze::misses() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _misses;
+}
@@ -0,0 +1,110 @@
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+
+#include "../include/generator.h"
+#include "../include/maze.h"
+
+namespace {
+
+const Algorithm ALGORITHMS[] = {
+    Algorithm::CELL_STACK,   Algorithm::RECURSIVE,     Algorithm::BACKTRACKER,
+    Algorithm::PRIM,         Algorithm::GROWING_TREE,  Algorithm::HUNT_AND_KILL,
+    Algorithm::UNIFORM};
+
+} // namespace
+
+
+const char *algorithmName(Algorithm algorithm) {
+  switch (algorithm) {
+  case Algorithm::CELL_STACK:
+    return "stack";
+  case Algorithm::RECURSIVE:
+    return "recursive";
+  case Algorithm::BACKTRACKER:
+    return "backtracker";
+  case Algorithm::PRIM:
+    return "prim";
+  case Algorithm::GROWING_TREE:
+    return "growing-tree";
+  case Algorithm::HUNT_AND_KILL:
+    return "hunt-and-kill";
+  case Algorithm::UNIFORM:
+    return "uniform";
+  }
+  throw std::runtime_error("Unknown algorithm.");
+}
+
+
+Algorithm parseAlgorithm(const std::string &name) {
+  for (Algorithm algorithm : ALGORITHMS) {
+    if (name == algorithmName(algorithm))
+      return algorithm;
+  }
+  throw std::runtime_error("Unknown algorithm '" + name + "', expected " +
+                           algorithmNames() + ".");
+}
+
+
+std::string algorithmNames() {
+  std::string names;
+  for (Algorithm algorithm : ALGORITHMS) {
+    if (!names.empty())
+      names += '|';
+    names += algorithmName(algorithm);
+  }
+  return names;
+}
+
+
+void MazeGenerator::seed(uint64_t seed) {
+  std::seed_seq sequence{uint32_t(seed), uint32_t(seed >> 32)};
+  switch (_algorithm) {
+  case Algorithm::CELL_STACK:
+  case Algorithm::RECURSIVE:
+    std::srand(uint32_t(seed ^ (seed >> 32)));
+    break;
+  case Algorithm::BACKTRACKER:
+    _backtracker.rng().seed(sequence);
+    break;
+  case Algorithm::PRIM:
+    _prim.rng().seed(sequence);
+    break;
+  case Algorithm::GROWING_TREE:
+    _growingTree.rng().seed(sequence);
+    break;
+  case Algorithm::HUNT_AND_KILL:
+    _huntAndKill.rng().seed(sequence);
+    break;
+  case Algorithm::UNIFORM:
+    _uniform.rng().seed(sequence);
+    break;
+  }
+}
+
+
+void MazeGenerator::generate(Grid &grid, int startX, int startY) {
+  switch (_algorithm) {
+  case Algorithm::CELL_STACK:
+    generateNewMazeCellStack(startX, startY, grid);
+    break;
+  case Algorithm::RECURSIVE:
+    generateNewMazeCellRecursive(startX, startY, grid);
+    break;
+  case Algorithm::BACKTRACKER:
+    _backtracker.generate(grid, startX, startY);
+    break;
+  case Algorithm::PRIM:
+    _prim.generate(grid, startX, startY);
+    break;
+  case Algorithm::GROWING_TREE:
+    _growingTree.generate(grid, startX, startY);
+    break;
+  case Algorithm::HUNT_AND_KILL:
+    _huntAndKill.generate(grid, startX, startY);
+    break;
+  case Algorithm::UNIFORM:
+    _uniform.generate(grid, startX, startY);
+    break;
+  }
+}
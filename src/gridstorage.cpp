@@ -0,0 +1,99 @@
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <system_error>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define GRIDSTORAGE_MMAP 1
+#endif
+
+#ifdef __linux__
+#include <linux/magic.h>
+#include <sys/vfs.h>
+#endif
+
+#include "../include/GridStorage.h"
+
+#ifdef GRIDSTORAGE_MMAP
+
+namespace {
+
+// A grid file on tmpfs lives in memory and swap, which defeats the point of
+// mapping it, so say so once.
+void warnIfTmpfs([[maybe_unused]] int fd,
+                 [[maybe_unused]] const std::string &directory) {
+#ifdef __linux__
+  static std::atomic<bool> warned(false);
+  struct statfs info;
+  if (fstatfs(fd, &info) == 0 && info.f_type == TMPFS_MAGIC &&
+      !warned.exchange(true)) {
+    std::cerr << "Warning: " << directory
+              << " is a tmpfs, so a mapped grid there is kept in memory and "
+                 "swap; set TMPDIR to a directory on disk.\n";
+  }
+#endif
+}
+
+} // namespace
+
+void *mapTemporary(size_t bytes) {
+  // /var/tmp rather than /tmp, which is often a tmpfs
+  const char *variable = std::getenv("TMPDIR");
+  const std::string directory = variable && *variable ? variable : "/var/tmp";
+  std::string path = directory + "/maze-grid-XXXXXX";
+
+  const int fd = mkstemp(path.data());
+  if (fd < 0)
+    throw std::system_error(errno, std::generic_category(),
+                            "Could not create a grid file in " + directory);
+  unlink(path.c_str()); // gone once the mapping is
+  warnIfTmpfs(fd, directory);
+
+  // ftruncate leaves the file sparse: no disk space is used until a page
+  // is written back, and untouched pages read as zeros
+  const size_t length = bytes ? bytes : 1;
+  void *address = MAP_FAILED;
+  if (ftruncate(fd, length) == 0)
+    address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  const int error = errno;
+  close(fd); // the mapping keeps the file open
+  if (address == MAP_FAILED)
+    throw std::system_error(error, std::generic_category(),
+                            "Could not map a grid file of " +
+                                std::to_string(bytes) + " bytes");
+
+  // a new grid is filled front to back right away
+  adviseMapping(address, length, GridAccess::SEQUENTIAL);
+  return address;
+}
+
+void unmapTemporary(void *address, size_t bytes) {
+  munmap(address, bytes ? bytes : 1);
+}
+
+void adviseMapping(const void *address, size_t bytes, GridAccess access) {
+  // madvise wants a page-aligned start
+  const uintptr_t page = sysconf(_SC_PAGESIZE);
+  const uintptr_t start = reinterpret_cast<uintptr_t>(address) & ~(page - 1);
+  const uintptr_t end = reinterpret_cast<uintptr_t>(address) + bytes;
+  const int advice = access == GridAccess::SEQUENTIAL ? MADV_SEQUENTIAL
+                     : access == GridAccess::RANDOM   ? MADV_RANDOM
+                                                      : MADV_NORMAL;
+  madvise(reinterpret_cast<void *>(start), end - start, advice);
+}
+
+#else
+
+void *mapTemporary(size_t bytes) { return ::operator new(bytes ? bytes : 1); }
+
+void unmapTemporary(void *address, size_t) { ::operator delete(address); }
+
+void adviseMapping(const void *, size_t, GridAccess) {}
+
+#endif
@@ -1,277 +1,163 @@
-#include <algorithm>
-#include <array>
 #include <ctime>
-#include <exception>
 #include <iostream>
 #include <random>
-#include <stack>
-#include <vector>
+#include <stdexcept>
 
 #include "../include/Color_Space.h"
 #include "../include/Timer.h"
+#include "../include/batch.h"
+#include "../include/generator.h"
+#include "../include/maze.h"
+#include "../include/mazefile.h"
+#include "../include/options.h"
 #include "../include/picture.h"
-
-#define CELL_SIZE 3;
-
-enum cellState { WALL, UNVISITED, VISITED, PATH, WRONG_PATH };
-
-
-bool contains(std::array<int, 4> &arr, int dir) {
-  return std::find(arr.begin(), arr.end(), dir) != arr.end();
+#include "../include/tilepyramid.h"
+
+
+void runBatchMode(const Options &options, uint64_t seed) {
+  TIMER_ZONE("runBatch");
+
+  BatchOptions batch;
+  batch.count = options.batchCount;
+  batch.minSize = options.minSize;
+  batch.maxSize = options.maxSize;
+  batch.seedBase = seed;
+  batch.algorithm = options.algorithm;
+  batch.solve = options.solve;
+  batch.scale = options.scale;
+  batch.style = options.style;
+  batch.threads = options.threads;
+  if (!options.noOutput)
+    batch.outputDir = options.output;
+
+  printBatchStats(runBatch(batch));
 }
 
 
-// returns random even number between 2 and maxWidth - 1;
-int getStart(int max) { return 2 + (std::rand() % ((max - 2) / 2)) * 2; }
-
-
-void generateNewMazeCellStack(int startX, int startY,
-                              std::vector<std::vector<cellState>> &grid) {
-
-  Timer timer("generateNewMazeCellStack");
-
-  const static std::array<std::pair<int, int>, 4> directions = {
-      {{0, -2}, {0, 2}, {-2, 0}, {2, 0}}};
+// generates the maze the options describe
+void generateMaze(const Options &options, uint64_t seed, Grid &grid) {
+  // getStart() draws from std::rand, which takes 32 bits
+  std::srand(uint32_t(seed ^ (seed >> 32)));
 
-  std::stack<std::pair<int, int>> cellStack;
-  grid.at(startY).at(startX) = VISITED;
-  cellStack.push({startX, startY});
-  std::array<int, 4> moveOptions = {0, 1, 2, 3}; // move options are reshuffled
-
-  while (!cellStack.empty()) {
-    std::random_shuffle(moveOptions.begin(), moveOptions.end());
-    bool moved = false;
-    auto [currX, currY] = cellStack.top();
+  // Ensures odd value by rounding up
+  const int width = options.width | 1;
+  const int height = options.height | 1;
 
-    for (size_t i = 0; i < directions.size(); i++) {
-      const int dir = moveOptions[i];
+  const int startX = getStart(width);
+  const int startY = getStart(height);
 
-      const int nextX = currX + directions[dir].first;
-      const int nextY = currY + directions[dir].second;
-      const int midX = currX + directions[dir].first / 2;
-      const int midY = currY + directions[dir].second / 2;
+  const uint64_t cells = uint64_t(width) * height;
 
-      if (grid.at(nextY).at(nextX) != VISITED) {
-        grid.at(midY).at(midX) = VISITED; // create a break in a wall
-        grid.at(nextY).at(nextX) = VISITED;
-        cellStack.push({nextX, nextY});
-        moved = true;
-        break;
-      }
-    }
+  grid.assign(width, height, UNVISITED);
+  MazeGenerator generator(options.algorithm);
+  generator.seed(seed);
 
-    if (!moved) {
-      cellStack.pop(); // backtrack if no moves are possible
-    }
+  {
+    TIMER_ZONE_ITEMS("initializeMaze", cells);
+    initializeMaze(grid);
+  }
+  {
+    TIMER_ZONE_ITEMS("generate", cells);
+    generator.generate(grid, startX, startY);
   }
 }
 
-void generateNewMazeCellRecursive(int currX, int currY,
-                                  std::vector<std::vector<cellState>> &grid) {
-
-  // setting a pixel grey denotes the cell as "visited"
-  grid.at(currY).at(currX) = VISITED;
-
-  // maze complete
-  if (grid.at(currY - 2).at(currX) == VISITED &&
-      grid.at(currY + 2).at(currX) == VISITED &&
-      grid.at(currY).at(currX - 2) == VISITED &&
-      grid.at(currY).at(currX + 2) == VISITED) {
-    return;
 
+void runSingle(const Options &options, uint64_t seed) {
+  Grid grid(options.storage);
+  Algorithm algorithm = options.algorithm;
+  if (options.input.empty()) {
+    generateMaze(options, seed, grid);
   } else {
-
-    // Position deltas for each of the four 2D cartesian directions; skipping
-    // every other pixel to account for walls
-    const static std::array<std::pair<int, int>, 4> directions = {
-        {{0, -2}, {0, 2}, {-2, 0}, {2, 0}}};
-
-    std::array<int, 4> moveAttempts = {-1, -1, -1, -1};
-    size_t moveNum = 0;
-
-    while (moveNum < 4) {
-
-      // randomly try each direction
-      int dir;
-      do {
-        dir = std::rand() % 4;
-      } while (contains(moveAttempts, dir));
-
-      // store direction attempt to avoid duplicates
-      moveAttempts[moveNum] = dir;
-      moveNum++;
-
-      const int nextX = currX + directions[dir].first;
-      const int nextY = currY + directions[dir].second;
-      const int midX = currX + directions[dir].first / 2;
-      const int midY = currY + directions[dir].second / 2;
-
-      if (grid.at(nextY).at(nextX) != VISITED) {
-        grid.at(midY).at(midX) = VISITED; // Create a break in a wall
-        generateNewMazeCellRecursive(nextX, nextY, grid);
-      }
-    }
+    TIMER_ZONE("loadMaze");
+    const MazeFile file(options.input);
+    file.view().toGrid(grid);
+    seed = file.info().seed;
+    algorithm = file.info().algorithm;
   }
-}
+  const uint64_t cells = grid.size();
 
+  if (options.solve)
+    solveMaze(grid);
 
-void initializeMaze(std::vector<std::vector<cellState>> &grid) {
-  const size_t width = grid.at(0).size();
-  const size_t height = grid.size();
+  if (options.noOutput)
+    return;
 
-  if (height < 5 || width < 5)
-    throw std::runtime_error("Both width and height must be greater than 4.");
+  if (options.format == OutputFormat::MAZE) {
+    TIMER_ZONE_ITEMS("writeMazeFile", cells);
+    writeMazeFile(options.output.empty() ? "maze.maze" : options.output, grid,
+                  seed, algorithm);
+    return;
+  }
 
-  // Initialize grid of walls
-  for (size_t i = 2; i < height - 2; i += 2) {
-    for (size_t j = 2; j < width - 2; j += 2) {
-      grid.at(i).at(j) = WALL;
-    }
+  if (options.format == OutputFormat::TILES) {
+    TIMER_ZONE_ITEMS("writeTilePyramid", cells);
+    TilePyramidOptions tiles;
+    tiles.scale = options.scale;
+    tiles.threads = options.threads;
+    writeTilePyramid(grid, options.output.empty() ? "maze" : options.output,
+                     tiles);
+    return;
   }
 
-  // Create a border of "visited" cells; simplifies generation algorithm
-  for (size_t i = 0; i < width; ++i) {
-    grid.at(0).at(i) = VISITED;
-    grid.at(height - 1).at(i) = VISITED;
+  Picture pic;
+  {
+    TIMER_ZONE_ITEMS("renderMaze", cells);
+    if (options.style == RenderStyle::DISTANCE)
+      renderMazeDistance(grid, pic, options.scale, distancePalette());
+    else
+      renderMaze(grid, pic, options.scale);
   }
-  for (size_t j = 0; j < height; ++j) {
-    grid.at(j).at(0) = VISITED;
-    grid.at(j).at(width - 1) = VISITED;
+  if (options.output == "-") {
+    // straight from the encoder's buffer to standard output
+    TIMER_ZONE_ITEMS("save", cells);
+    pic.encode([](std::span<const unsigned char> png) {
+      std::cout.write(reinterpret_cast<const char *>(png.data()), png.size());
+      std::cout.flush();
+    });
+  } else {
+    TIMER_ZONE_ITEMS("save", cells);
+    pic.save(options.output.empty() ? "maze.png" : options.output);
   }
-
-  // Create openings in maze perimeter for start and end
-  grid.at(2).at(1) = VISITED;
-  grid.at(height - 3).at(width - 2) = VISITED;
 }
 
-std::pair<int, int> getDimensions() {
-  int width, height;
-
-  std::cout << "Enter an odd number, 5 or greater." << std::endl;
-  std::cout << "Width [px]: ";
-  std::cin >> width;
-  std::cout << "Height [px]: ";
-  std::cin >> height;
-
-  return {width, height};
-};
 
+int main(int argc, char *argv[]) {
 
-void createPicture(const std::vector<std::vector<cellState>> &grid) {
-  Timer timer("createPicture");
-  const int n = 1; // scale
-  const size_t height = grid.size();
-  const size_t width = grid.at(0).size();
-  Picture pic(width * n, height * n, 0, 0, 0);
-
-  for (size_t i = 0; i < width; i++) {
-    for (size_t j = 0; j < height; j++) {
-      switch (grid.at(j).at(i)) {
-
-      case UNVISITED:
-        break;
-      case VISITED:
-      case WRONG_PATH:
-        pic.set(i * n, j * n, 50, 50, 50);
-        break;
-      case PATH:
-        pic.set(i * n, j * n, 127, 127, 127);
-        break;
-      default:
-        throw std::runtime_error("Grid populated with unknown option.");
-        break;
-      }
-    }
+  Options options;
+  try {
+    options = parseOptions(argc, argv);
+  } catch (const std::runtime_error &error) {
+    std::cerr << error.what() << "\n\n";
+    printUsage(argv[0], std::cerr);
+    return 1;
   }
 
-  pic.save("maze.png");
-}
-
-
-void removeBorder(std::vector<std::vector<cellState>> &grid) {
-  const size_t width = grid.at(0).size() - 2;
-  const size_t height = grid.size() - 2;
-
-  std::vector<std::vector<cellState>> newGrid(
-      height, std::vector<cellState>(width, UNVISITED));
-
-  for (size_t i = 1; i < grid.size() - 1; ++i) {
-    newGrid.at(i - 1) =
-        std::vector<cellState>(grid[i].begin() + 1, grid[i].end() - 1);
+  if (options.help) {
+    printUsage(argv[0]);
+    return 0;
   }
 
-  grid = newGrid;
-}
-
-void solveMaze(std::vector<std::vector<cellState>> &grid) {
-
-  Timer timer("solveMaze");
-
-  const static std::array<std::pair<int, int>, 4> directions = {
-      {{0, 1}, {1, 0}, {0, -1}, {-1, 0}}};
-
-  int startX = 1;
-  int startY = 2;
-
-  const int width = grid.at(0).size();
-  const int height = grid.size();
-
-  std::stack<std::pair<int, int>> cellStack;
-  cellStack.push({startX, startY});
-
-  while (!cellStack.empty()) {
-
-    bool moved = false;
-    auto [currX, currY] = cellStack.top();
-
-    if (currX < 1 || currX > width - 2 || currY < 1 || currY > height - 2) {
-      return;
-    }
-
-    grid.at(currY).at(currX) = PATH;
-
-    for (auto dir : directions) {
-      const int nextX = currX + dir.first;
-      const int nextY = currY + dir.second;
-
-      if (grid.at(nextY).at(nextX) == VISITED) {
-        cellStack.push({nextX, nextY});
-        moved = true;
-        break;
-      }
-    }
-
-    if (!moved) {
-      grid.at(currY).at(currX) = WRONG_PATH;
-      cellStack.pop();
-    }
+  const uint64_t seed = options.hasSeed ? options.seed : std::time(0);
+
+  Timer::Start();
+  if (!options.trace.empty())
+    Timer::enableTrace(options.trace);
+  if (options.memory)
+    Timer::enableMemory();
+  if (options.counters && !Timer::enableCounters())
+    std::cerr << "Hardware counters unavailable, timing only." << std::endl;
+  try {
+    if (options.batchCount > 0)
+      runBatchMode(options, seed);
+    else
+      runSingle(options, seed);
+  } catch (const std::exception &error) {
+    std::cerr << error.what() << std::endl;
+    return 1;
   }
-}
-
-int main() {
-
-  std::srand(std::time(0));
-
-  //   std::pair<int, int> dimensions = getDimensions();
-  //   auto [width, height] = dimensions;
-  // Ensures odd value by rounding up
-
-  int width = 100;
-  int height = 100;
-
-  width |= 1;
-  height |= 1;
-
-  const int startX = getStart(width);
-  const int startY = getStart(height);
-
-  std::vector<std::vector<cellState>> grid(
-      height, std::vector<cellState>(width, UNVISITED));
 
-  initializeMaze(grid);
-  //   generateNewMazeCellRecursive(startX, startY, grid);
-  generateNewMazeCellStack(startX, startY, grid);
-  solveMaze(grid);
-  //   removeBorder(grid);
-  createPicture(grid);
+  // keep the reports out of a PNG written to standard output
+  if (options.timer || options.counters || options.memory)
+    Timer::printData(options.output == "-" ? std::cerr : std::cout);
 }
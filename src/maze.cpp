@@ -0,0 +1,598 @@
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <random>
+#include <stack>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "../include/Color_Space.h"
+#include "../include/Timer.h"
+#include "../include/maze.h"
+#include "../include/picture.h"
+
+
+bool contains(std::array<int, 4> &arr, int dir) {
+  return std::find(arr.begin(), arr.end(), dir) != arr.end();
+}
+
+
+int getStart(int max) { return 2 + (std::rand() % ((max - 2) / 2)) * 2; }
+
+
+void generateNewMazeCellStack(int startX, int startY, Grid &grid) {
+
+  TIMER_ZONE_ITEMS("generateNewMazeCellStack", grid.size());
+
+  const static std::array<std::pair<int, int>, 4> directions = {
+      {{0, -2}, {0, 2}, {-2, 0}, {2, 0}}};
+
+  std::stack<std::pair<int, int>> cellStack;
+  grid.at(startX, startY) = VISITED;
+  cellStack.push({startX, startY});
+  std::array<int, 4> moveOptions = {0, 1, 2, 3}; // move options are reshuffled
+
+  while (!cellStack.empty()) {
+    std::random_shuffle(moveOptions.begin(), moveOptions.end());
+    bool moved = false;
+    auto [currX, currY] = cellStack.top();
+
+    for (size_t i = 0; i < directions.size(); i++) {
+      const int dir = moveOptions[i];
+
+      const int nextX = currX + directions[dir].first;
+      const int nextY = currY + directions[dir].second;
+      const int midX = currX + directions[dir].first / 2;
+      const int midY = currY + directions[dir].second / 2;
+
+      if (grid.at(nextX, nextY) != VISITED) {
+        grid.at(midX, midY) = VISITED; // create a break in a wall
+        grid.at(nextX, nextY) = VISITED;
+        cellStack.push({nextX, nextY});
+        moved = true;
+        break;
+      }
+    }
+
+    if (!moved) {
+      cellStack.pop(); // backtrack if no moves are possible
+    }
+  }
+}
+
+void generateNewMazeCellRecursive(int currX, int currY, Grid &grid) {
+
+  // setting a pixel grey denotes the cell as "visited"
+  grid.at(currX, currY) = VISITED;
+
+  // maze complete
+  if (grid.at(currX, currY - 2) == VISITED &&
+      grid.at(currX, currY + 2) == VISITED &&
+      grid.at(currX - 2, currY) == VISITED &&
+      grid.at(currX + 2, currY) == VISITED) {
+    return;
+
+  } else {
+
+    // Position deltas for each of the four 2D cartesian directions; skipping
+    // every other pixel to account for walls
+    const static std::array<std::pair<int, int>, 4> directions = {
+        {{0, -2}, {0, 2}, {-2, 0}, {2, 0}}};
+
+    std::array<int, 4> moveAttempts = {-1, -1, -1, -1};
+    size_t moveNum = 0;
+
+    while (moveNum < 4) {
+
+      // randomly try each direction
+      int dir;
+      do {
+        dir = std::rand() % 4;
+      } while (contains(moveAttempts, dir));
+
+      // store direction attempt to avoid duplicates
+      moveAttempts[moveNum] = dir;
+      moveNum++;
+
+      const int nextX = currX + directions[dir].first;
+      const int nextY = currY + directions[dir].second;
+      const int midX = currX + directions[dir].first / 2;
+      const int midY = currY + directions[dir].second / 2;
+
+      if (grid.at(nextX, nextY) != VISITED) {
+        grid.at(midX, midY) = VISITED; // Create a break in a wall
+        generateNewMazeCellRecursive(nextX, nextY, grid);
+      }
+    }
+  }
+}
+
+
+void initializeMaze(Grid &grid) {
+  const int width = grid.width();
+  const int height = grid.height();
+
+  if (height < 5 || width < 5)
+    throw std::runtime_error("Both width and height must be greater than 4.");
+
+  // Initialize grid of walls
+  for (int i = 2; i < height - 2; i += 2) {
+    for (int j = 2; j < width - 2; j += 2) {
+      grid.at(j, i) = WALL;
+    }
+  }
+
+  // Create a border of "visited" cells; simplifies generation algorithm
+  for (int i = 0; i < width; ++i) {
+    grid.at(i, 0) = VISITED;
+    grid.at(i, height - 1) = VISITED;
+  }
+  for (int j = 0; j < height; ++j) {
+    grid.at(0, j) = VISITED;
+    grid.at(width - 1, j) = VISITED;
+  }
+
+  // Create openings in maze perimeter for start and end
+  grid.at(1, 2) = VISITED;
+  grid.at(width - 2, height - 3) = VISITED;
+}
+
+
+namespace {
+
+// the pixel renderMaze() draws for a grid cell
+uint32_t grayPixel(cellState state) {
+  switch (state) {
+  case UNVISITED:
+    return clrspc::to_rgba_word(clrspc::gray8(0));
+  case VISITED:
+  case WRONG_PATH:
+    return clrspc::to_rgba_word(clrspc::gray8(50));
+  case PATH:
+    return clrspc::to_rgba_word(clrspc::gray8(127));
+  default:
+    throw std::runtime_error("Grid populated with unknown option.");
+  }
+}
+
+// Picture sizes are ints; the options reject such scales up front, but a
+// grid loaded from a file can be any size
+void checkScaledSize(const Grid &grid, int scale) {
+  if (int64_t(std::max(grid.width(), grid.height())) * scale > INT_MAX)
+    throw std::length_error("The scaled picture would be more than " +
+                            std::to_string(INT_MAX) + " pixels across.");
+}
+
+} // namespace
+
+
+void renderMaze(const Grid &grid, Picture &pic, int scale) {
+  checkScaledSize(grid, scale);
+  const int n = scale;
+  const int height = grid.height();
+  const int width = grid.width();
+  pic.assign(width * n, height * n, 0, 0, 0);
+
+  // Writes the first pixel row of each grid row in place, then copies it
+  // to the other n - 1 rows of that grid row.
+  for (int j = 0; j < height; j++) {
+    unsigned char *out = pic.row(j * n);
+    for (int i = 0; i < width; i++) {
+      const uint32_t color = grayPixel(grid[grid.index(i, j)]);
+      for (int dx = 0; dx < n; dx++, out += 4)
+        std::memcpy(out, &color, 4);
+    }
+    for (int dy = 1; dy < n; dy++)
+      std::memcpy(pic.row(j * n + dy), pic.row(j * n), 4 * size_t(width) * n);
+  }
+}
+
+
+
+void renderMazeRegion(const Grid &grid, Picture &pic, int scale, int left,
+                      int top, int width, int height) {
+  const int n = scale;
+  if (left < 0 || top < 0 || width < 0 || height < 0 ||
+      int64_t(left) + width > int64_t(grid.width()) * n ||
+      int64_t(top) + height > int64_t(grid.height()) * n)
+    throw std::out_of_range("Region outside the rendered maze.");
+  pic.assign(width, height, 0, 0, 0);
+
+  // Like renderMaze(), writes a pixel row once per grid row and copies it
+  // down; the region may start and end partway through a cell.
+  for (int y = 0; y < height; y++) {
+    const int j = (top + y) / n;
+    if (y > 0 && (top + y) % n != 0) {
+      std::memcpy(pic.row(y), pic.row(y - 1), 4 * size_t(width));
+      continue;
+    }
+    unsigned char *out = pic.row(y);
+    for (int x = 0; x < width;) {
+      const int i = (left + x) / n;
+      const int run = std::min(width - x, (i + 1) * n - (left + x));
+      const uint32_t color = grayPixel(grid[grid.index(i, j)]);
+      for (int k = 0; k < run; k++, out += 4)
+        std::memcpy(out, &color, 4);
+      x += run;
+    }
+  }
+}
+
+namespace {
+
+const uint32_t UNREACHED = UINT32_MAX;
+
+bool isOpen(cellState state) { return state >= VISITED; }
+
+// the passages out of a maze cell, one bit per direction, in the order of
+// the offsets the walks take them in
+enum Passage : uint8_t { EAST = 1, WEST = 2, SOUTH = 4, NORTH = 8 };
+
+/**
+   Sets passages[cy * columns + cx] to the open passages out of maze cell
+   (cx, cy). The entrance and exit lead off the lattice and are left out,
+   so a walk along the masks never needs a bounds check.
+*/
+void cellPassages(const Grid &grid, int columns, int rows,
+                  std::vector<uint8_t> &passages) {
+  passages.resize(size_t(columns) * rows);
+  const ptrdiff_t stride = grid.stride();
+  for (int cy = 0; cy < rows; cy++) {
+    const cellState *cell = grid.data() + grid.index(2, 2 + 2 * cy);
+    uint8_t *out = passages.data() + size_t(cy) * columns;
+    for (int cx = 0; cx < columns; cx++, cell += 2)
+      out[cx] = uint8_t(isOpen(cell[1]) * EAST | isOpen(cell[-1]) * WEST |
+                        isOpen(cell[stride]) * SOUTH |
+                        isOpen(cell[-stride]) * NORTH);
+    out[0] &= ~WEST;
+    out[columns - 1] &= ~EAST;
+  }
+  for (int cx = 0; cx < columns; cx++) {
+    passages[cx] &= ~NORTH;
+    passages[size_t(rows - 1) * columns + cx] &= ~SOUTH;
+  }
+}
+
+/**
+   Walks a perfect maze depth first from cell 0. A stack entry packs a
+   cell's distance, its index and the passage back to its parent, so a cell
+   pushes every other passage out of it without looking at the cells they
+   lead to: in a spanning tree each one leads to a new cell. That leaves
+   one load per cell, of its passages, against one per neighbor for a walk
+   that has to check whether a cell was seen, and halves the time.
+   @return false unless the walk popped every cell exactly once: a grid
+   with loops or with cells it cannot reach, where distance is incomplete
+*/
+bool walkTree(const uint8_t *passages, int columns, size_t cells,
+              uint32_t *distance, uint32_t &farthest) {
+  // entry: distance << 32 | cell << 4 | passage back to the parent; a
+  // move adds to the low word, which wraps for the negative ones
+  const uint32_t moves[] = {uint32_t(1) << 4 | WEST, uint32_t(-1) << 4 | EAST,
+                            uint32_t(columns) << 4 | NORTH,
+                            uint32_t(-columns) << 4 | SOUTH};
+  std::vector<uint64_t> stack(1024);
+  size_t top = 0;
+  stack[top++] = 0;
+  farthest = 0;
+
+  size_t popped = 0;
+  for (; top > 0; popped++) {
+    if (popped == cells)
+      return false;
+    if (top + 4 > stack.size())
+      stack.resize(2 * stack.size());
+    const uint64_t entry = stack[--top];
+    const uint32_t cell = uint32_t(entry) >> 4;
+    const uint32_t here = uint32_t(entry >> 32);
+    distance[cell] = here;
+    farthest = std::max(farthest, here);
+
+    const unsigned open = passages[cell] & ~unsigned(entry & 15);
+    const uint64_t next = uint64_t(here + 1) << 32;
+    const uint32_t from = uint32_t(entry) & ~15u;
+    for (int k = 0; k < 4; k++) {
+      stack[top] = next | uint32_t(from + moves[k]);
+      top += (open >> k) & 1;
+    }
+  }
+  return popped == cells;
+}
+
+/**
+   Walks any grid depth first from cell 0, keeping a neighbor only when it
+   has no distance yet; for grids with loops, where it finds the length of
+   some route, not always the shortest.
+*/
+uint32_t walkGraph(const uint8_t *passages, int columns, uint32_t *distance) {
+  const ptrdiff_t moves[] = {1, -1, columns, -ptrdiff_t(columns)};
+  std::vector<size_t> stack(1024);
+  size_t top = 0;
+  stack[top++] = 0;
+  distance[0] = 0;
+  uint32_t farthest = 0;
+
+  while (top > 0) {
+    if (top + 4 > stack.size())
+      stack.resize(2 * stack.size());
+    const size_t cell = stack[--top];
+    const uint32_t next = distance[cell] + 1;
+    farthest = std::max(farthest, distance[cell]);
+    const unsigned open = passages[cell];
+    for (int k = 0; k < 4; k++) {
+      // a closed passage looks at the cell itself, which is never new
+      const size_t neighbor = cell + (moves[k] & -ptrdiff_t((open >> k) & 1));
+      const bool fresh = distance[neighbor] == UNREACHED;
+      distance[neighbor] = fresh ? next : distance[neighbor];
+      stack[top] = neighbor;
+      top += fresh;
+    }
+  }
+  return farthest;
+}
+
+/**
+   Fills distance with the distance, in cells, of every maze cell from the
+   one at (2, 2). Maze cell (cx, cy) is grid pixel (2 + 2 cx, 2 + 2 cy) and
+   distance entry cy * columns + cx. Cells that cannot be reached get
+   UNREACHED. A perfect maze reaches every cell, so the entries are only
+   filled up front when the tree walk finds it is not one.
+
+   Every generator carves a perfect maze, a spanning tree of the cells,
+   where the one route to a cell is also its breadth-first distance. So
+   this walks the tree depth first, which follows corridors through
+   memory, instead of breadth first, whose frontier is spread over the
+   whole grid. A grid with loops gets the length of some route, not always
+   the shortest.
+   @return the largest distance found
+*/
+uint32_t cellDistances(const Grid &grid,
+                       std::unique_ptr<uint32_t[]> &distance) {
+  const int columns = (grid.width() - 3) / 2;
+  const int rows = (grid.height() - 3) / 2;
+  if (columns <= 0 || rows <= 0) {
+    distance.reset();
+    return 0;
+  }
+  const size_t cells = size_t(columns) * rows;
+  distance = std::make_unique_for_overwrite<uint32_t[]>(cells);
+  if (!isOpen(grid.at(2, 2))) {
+    std::fill_n(distance.get(), cells, UNREACHED);
+    return 0;
+  }
+
+  std::vector<uint8_t> passages;
+  cellPassages(grid, columns, rows, passages);
+  uint32_t farthest = 0;
+  if (cells < (size_t(1) << 28) &&
+      walkTree(passages.data(), columns, cells, distance.get(), farthest))
+    return farthest;
+  std::fill_n(distance.get(), cells, UNREACHED);
+  return walkGraph(passages.data(), columns, distance.get());
+}
+
+} // namespace
+
+
+std::vector<clrspc::Rgb8> distancePalette(int size) {
+  // 80% of the hue circle runs from red to violet without wrapping back
+  const std::vector<Tristimulus> rainbow =
+      clrspc::get_rainbow_colors(size, {255, 0, 0}, 80.f);
+  std::vector<clrspc::Rgb8> palette(rainbow.size());
+  std::transform(rainbow.begin(), rainbow.end(), palette.begin(),
+                 [](Tristimulus c) { return clrspc::to_rgb8(c); });
+  return palette;
+}
+
+
+void renderMazeDistance(const Grid &grid, Picture &pic, int scale,
+                        const std::vector<clrspc::Rgb8> &palette) {
+  if (palette.empty())
+    throw std::invalid_argument("The distance palette must not be empty.");
+  checkScaledSize(grid, scale);
+
+  const int n = scale;
+  const int height = grid.height();
+  const int width = grid.width();
+  const int columns = (width - 3) / 2;
+  const int rows = (height - 3) / 2;
+
+  std::unique_ptr<uint32_t[]> distance;
+  const uint32_t farthest = cellDistances(grid, distance);
+  const uint32_t *lattice = distance.get();
+
+  // Pixel distances count grid steps from the entrance opening at (1, 2):
+  // cell d is 2d + 1 steps away and the passage after it 2d + 2, so the
+  // exit opening is the farthest pixel there can be.
+  const uint64_t maxSteps = 2 * uint64_t(farthest) + 2;
+  const uint64_t last = palette.size() - 1;
+  // index = steps * last / maxSteps, as one multiply and shift per pixel
+  const uint64_t indexScale = (last << 32) / maxSteps;
+
+  // the palette and the grays as ready-made pixels
+  std::vector<uint32_t> colorTable(palette.size());
+  std::transform(palette.begin(), palette.end(), colorTable.begin(),
+                 [](clrspc::Rgb8 c) { return clrspc::to_rgba_word(c); });
+  const uint32_t *colors = colorTable.data();
+  const uint32_t grays[] = {0, grayPixel(UNVISITED), grayPixel(VISITED),
+                            grayPixel(PATH), grayPixel(WRONG_PATH)};
+
+  // Passages open and close at random, so shade() looks everything up and
+  // selects without branching; only the never-taken WALL check branches.
+  // Everything it reads is a local copy, which the pixel stores through
+  // unsigned char cannot alias, so nothing is reloaded per pixel.
+  auto shade = [colors, grays, maxSteps, indexScale](cellState state,
+                                                     uint64_t steps) {
+    if (state == WALL)
+      grayPixel(state); // throws
+    const bool reached = steps <= maxSteps; // false next to unreached cells
+    const uint32_t color =
+        colors[(std::min(steps, maxSteps) * indexScale) >> 32];
+    const uint32_t keep = -uint32_t(isOpen(state) & reached);
+    return (color & keep) | (grays[state] & ~keep);
+  };
+  // a passage is one step past the nearer of the two cells it joins
+  auto passage = [](uint32_t before, uint32_t after) {
+    return 2 * uint64_t(std::min(before, after)) + 2;
+  };
+
+  pic.resize(width * n, height * n); // every pixel is written below
+
+  // Writes the first pixel row of each grid row in place, then copies it
+  // to the other n - 1 rows of that grid row. Even rows alternate cells
+  // and the passages between them; odd rows alternate the passages to the
+  // next row and wall corners. Rows are independent, so bands of them go
+  // to separate threads. The scale is a compile-time 1 in the common case,
+  // which leaves a single store per pixel.
+  auto renderRows = [&](auto scale, int first, int last) {
+    for (int j = first; j < last; j++) {
+      const cellState *in = grid.data() + grid.index(0, j);
+      unsigned char *out = pic.row(j * n);
+      int done = 0; // grid pixels written so far
+      auto put = [&out, scale](uint32_t color) {
+        for (int dx = 0; dx < scale; dx++, out += 4)
+          std::memcpy(out, &color, 4);
+      };
+
+      if (j % 2 == 0 && j >= 2 && (j - 2) / 2 < rows) {
+        const uint32_t *cellRow = lattice + size_t(j - 2) / 2 * columns;
+        put(grayPixel(in[0]));
+        put(shade(in[1], 0)); // the entrance where open
+        for (int cx = 0; cx < columns; cx++) {
+          const int i = 2 + 2 * cx;
+          const uint32_t here = cellRow[cx];
+          put(shade(in[i], 2 * uint64_t(here) + 1));
+          const uint32_t after =
+              cx + 1 < columns ? cellRow[cx + 1] : UNREACHED;
+          put(shade(in[i + 1], passage(here, after)));
+        }
+        done = 2 + 2 * columns;
+      } else if (j % 2 != 0 && j >= 3 && (j - 1) / 2 < rows) {
+        const uint32_t *above = lattice + size_t(j - 3) / 2 * columns;
+        const uint32_t *below = above + columns;
+        put(grayPixel(in[0]));
+        put(grayPixel(in[1]));
+        for (int cx = 0; cx < columns; cx++) {
+          const int i = 2 + 2 * cx;
+          put(shade(in[i], passage(above[cx], below[cx])));
+          put(grayPixel(in[i + 1]));
+        }
+        done = 2 + 2 * columns;
+      }
+      // the border, the wall rows next to it and whatever the cells leave
+      for (int i = done; i < width; i++)
+        put(grayPixel(in[i]));
+
+      for (int dy = 1; dy < n; dy++)
+        std::memcpy(pic.row(j * n + dy), pic.row(j * n),
+                    4 * size_t(width) * n);
+    }
+  };
+  auto renderBand = [&](int first, int last, std::exception_ptr &failure) {
+    try {
+      if (n == 1)
+        renderRows(std::integral_constant<int, 1>(), first, last);
+      else
+        renderRows(n, first, last);
+    } catch (...) {
+      failure = std::current_exception();
+    }
+  };
+
+  const int threads =
+      std::clamp<int>(int64_t(width) * height / (1 << 18), 1,
+                      std::max(1u, std::thread::hardware_concurrency()));
+  std::vector<std::exception_ptr> failures(threads);
+  std::vector<std::thread> workers;
+  for (int t = 1; t < threads; t++)
+    workers.emplace_back(renderBand, int(int64_t(height) * t / threads),
+                         int(int64_t(height) * (t + 1) / threads),
+                         std::ref(failures[t]));
+  renderBand(0, height / threads, failures[0]);
+  for (std::thread &worker : workers)
+    worker.join();
+  for (const std::exception_ptr &failure : failures)
+    if (failure)
+      std::rethrow_exception(failure);
+}
+
+
+void createPicture(const Grid &grid) {
+  TIMER_ZONE("createPicture");
+  Picture pic;
+  renderMaze(grid, pic, 1);
+  pic.save("maze.png");
+}
+
+
+void removeBorder(Grid &grid) {
+  const int width = grid.width() - 2;
+  const int height = grid.height() - 2;
+
+  Grid newGrid(width, height, UNVISITED);
+
+  for (int i = 1; i < grid.height() - 1; ++i) {
+    for (int j = 1; j < grid.width() - 1; ++j) {
+      newGrid.at(j - 1, i - 1) = grid.at(j, i);
+    }
+  }
+
+  grid = newGrid;
+}
+
+void solveMaze(Grid &grid) {
+
+  TIMER_ZONE_ITEMS("solveMaze", grid.size());
+
+  std::vector<std::pair<int, int>> cellStack;
+  solveMaze(grid, cellStack);
+}
+
+void solveMaze(Grid &grid, std::vector<std::pair<int, int>> &cellStack) {
+
+  const static std::array<std::pair<int, int>, 4> directions = {
+      {{0, 1}, {1, 0}, {0, -1}, {-1, 0}}};
+
+  int startX = 1;
+  int startY = 2;
+
+  const int width = grid.width();
+  const int height = grid.height();
+
+  cellStack.clear();
+  cellStack.push_back({startX, startY});
+
+  while (!cellStack.empty()) {
+
+    bool moved = false;
+    auto [currX, currY] = cellStack.back();
+
+    if (currX < 1 || currX > width - 2 || currY < 1 || currY > height - 2) {
+      return;
+    }
+
+    grid.at(currX, currY) = PATH;
+
+    for (auto dir : directions) {
+      const int nextX = currX + dir.first;
+      const int nextY = currY + dir.second;
+
+      if (grid.at(nextX, nextY) == VISITED) {
+        cellStack.push_back({nextX, nextY});
+        moved = true;
+        break;
+      }
+    }
+
+    if (!moved) {
+      grid.at(currX, currY) = WRONG_PATH;
+      cellStack.pop_back();
+    }
+  }
+}
@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAZEFILE_MMAP 1
+#endif
+
+#include "../include/mazefile.h"
+
+namespace {
+
+const char MAGIC[8] = {'M', 'A', 'Z', 'E', 'G', 'R', 'I', 'D'};
+const uint32_t VERSION = 1;
+const size_t HEADER_SIZE = 64;
+const size_t ALGORITHM_NAME_SIZE = 24;
+
+void store32(unsigned char *out, uint32_t value) {
+  for (int i = 0; i < 4; i++)
+    out[i] = value >> (8 * i);
+}
+
+void store64(unsigned char *out, uint64_t value) {
+  for (int i = 0; i < 8; i++)
+    out[i] = value >> (8 * i);
+}
+
+uint32_t load32(const unsigned char *in) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++)
+    value |= uint32_t(in[i]) << (8 * i);
+  return value;
+}
+
+uint64_t load64(const unsigned char *in) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; i++)
+    value |= uint64_t(in[i]) << (8 * i);
+  return value;
+}
+
+bool isOpen(cellState state) { return state >= VISITED; }
+
+// bytes of cell data for a grid of the given size
+uint64_t dataBytes(int width, int height) {
+  return (uint64_t((width - 3) / 2) * ((height - 3) / 2) + 3) / 4;
+}
+
+// the error for a file that is not a maze file, or a damaged one
+std::runtime_error notMazeFile(const std::string &filename,
+                               const std::string &reason) {
+  return std::runtime_error(filename + ": not a maze file (" + reason + ").");
+}
+
+/**
+   Checks the header and returns what it describes.
+   @throws std::runtime_error if it is not a valid version 1 header for a
+   file of the given size, saying "<filename>: not a maze file (...)."
+*/
+MazeFileInfo parseHeader(const unsigned char *header, size_t fileSize,
+                         const std::string &filename) {
+  auto fail = [&](const std::string &reason) {
+    return notMazeFile(filename, reason);
+  };
+  if (fileSize < HEADER_SIZE)
+    throw fail("shorter than its header");
+  if (std::memcmp(header, MAGIC, 8) != 0)
+    throw fail("bad magic number");
+  if (load32(header + 8) != VERSION)
+    throw fail("unsupported version " + std::to_string(load32(header + 8)));
+  if (load32(header + 12) != MAZE_FILE_DATA_OFFSET)
+    throw fail("unexpected cell data offset");
+
+  MazeFileInfo info;
+  const uint32_t width = load32(header + 16);
+  const uint32_t height = load32(header + 20);
+  if (width < 5 || height < 5 || width % 2 == 0 || height % 2 == 0 ||
+      width > INT32_MAX || height > INT32_MAX)
+    throw fail("invalid size " + std::to_string(width) + "x" +
+               std::to_string(height));
+  info.width = width;
+  info.height = height;
+  info.seed = load64(header + 24);
+
+  const char *name = reinterpret_cast<const char *>(header + 32);
+  const std::string algorithm(name, strnlen(name, ALGORITHM_NAME_SIZE));
+  try {
+    info.algorithm = parseAlgorithm(algorithm);
+  } catch (const std::runtime_error &) {
+    throw fail("unknown algorithm '" + algorithm + "'");
+  }
+
+  const uint64_t bytes = load64(header + 56);
+  if (bytes != dataBytes(width, height) ||
+      fileSize < MAZE_FILE_DATA_OFFSET + bytes)
+    throw fail("truncated cell data");
+  return info;
+}
+
+} // namespace
+
+
+void writeMazeFile(const std::string &filename, const Grid &grid,
+                   uint64_t seed, Algorithm algorithm) {
+  const int width = grid.width();
+  const int height = grid.height();
+  if (width < 5 || height < 5 || width % 2 == 0 || height % 2 == 0)
+    throw std::invalid_argument(
+        "Maze files need odd grid sides of at least 5.");
+
+  std::vector<unsigned char> header(MAZE_FILE_DATA_OFFSET, 0);
+  std::memcpy(header.data(), MAGIC, 8);
+  store32(&header[8], VERSION);
+  store32(&header[12], MAZE_FILE_DATA_OFFSET);
+  store32(&header[16], width);
+  store32(&header[20], height);
+  store64(&header[24], seed);
+  std::strncpy(reinterpret_cast<char *>(&header[32]), algorithmName(algorithm),
+               ALGORITHM_NAME_SIZE);
+  store64(&header[56], dataBytes(width, height));
+
+  std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char *>(header.data()), header.size());
+
+  // Packs a band of lattice rows at a time. The bits of a cell never
+  // straddle bytes, so a band whose cell count is a multiple of 4 ends on
+  // a byte boundary; the last band is padded with zero bits.
+  const int columns = (width - 3) / 2;
+  const int rows = (height - 3) / 2;
+  const int band = 4 * std::max(1, (1 << 20) / columns);
+  std::vector<unsigned char> packed;
+  for (int first = 0; first < rows; first += band) {
+    const int last = std::min(rows, first + band);
+    packed.assign((size_t(last - first) * columns + 3) / 4, 0);
+    size_t k = 0;
+    for (int cy = first; cy < last; cy++) {
+      const cellState *cell = grid.data() + grid.index(2, 2 + 2 * cy);
+      for (int cx = 0; cx < columns; cx++, k++, cell += 2) {
+        // passages off the lattice are walls or one of the two openings,
+        // which the format leaves implicit
+        const unsigned east = cx + 1 < columns && isOpen(cell[1]);
+        const unsigned south = cy + 1 < rows && isOpen(cell[grid.stride()]);
+        packed[k / 4] |= (east | south << 1) << (2 * (k % 4));
+      }
+    }
+    out.write(reinterpret_cast<const char *>(packed.data()), packed.size());
+  }
+
+  out.close();
+  if (!out)
+    throw std::runtime_error("Could not write " + filename + ".");
+}
+
+
+cellState MazeView::at(int x, int y) const {
+  if (x < 0 || x >= _width || y < 0 || y >= _height)
+    throw std::out_of_range("Maze position out of range.");
+
+  if (x == 0 || y == 0 || x == _width - 1 || y == _height - 1)
+    return VISITED; // the border
+  if ((x == 1 && y == 2) || (x == _width - 2 && y == _height - 3))
+    return VISITED; // the entrance and exit
+  if (x == 1 || y == 1 || x == _width - 2 || y == _height - 2)
+    return UNVISITED; // walls around the lattice
+
+  const bool oddX = x % 2 != 0;
+  const bool oddY = y % 2 != 0;
+  if (!oddX && !oddY)
+    return VISITED; // every cell is carved
+  if (oddX && oddY)
+    return UNVISITED; // wall corners
+  if (oddX)
+    return eastOpen((x - 3) / 2, (y - 2) / 2) ? VISITED : UNVISITED;
+  return southOpen((x - 2) / 2, (y - 3) / 2) ? VISITED : UNVISITED;
+}
+
+
+void MazeView::toGrid(Grid &grid) const {
+  grid.assign(_width, _height, UNVISITED);
+  for (int x = 0; x < _width; x++) {
+    grid[grid.index(x, 0)] = VISITED;
+    grid[grid.index(x, _height - 1)] = VISITED;
+  }
+  for (int y = 0; y < _height; y++) {
+    grid[grid.index(0, y)] = VISITED;
+    grid[grid.index(_width - 1, y)] = VISITED;
+  }
+  grid[grid.index(1, 2)] = VISITED;
+  grid[grid.index(_width - 2, _height - 3)] = VISITED;
+
+  const ptrdiff_t stride = grid.stride();
+  for (int cy = 0; cy < rows(); cy++) {
+    cellState *cell = grid.data() + grid.index(2, 2 + 2 * cy);
+    for (int cx = 0; cx < _columns; cx++, cell += 2) {
+      const unsigned open = bits(cx, cy);
+      cell[0] = VISITED;
+      if (open & 1)
+        cell[1] = VISITED;
+      if (open & 2)
+        cell[stride] = VISITED;
+    }
+  }
+}
+
+
+MazeFile::MazeFile(const std::string &filename) {
+  const unsigned char *file;
+  size_t fileSize;
+
+#ifdef MAZEFILE_MMAP
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("Could not open " + filename + ".");
+  struct stat status;
+  if (fstat(fd, &status) != 0 || status.st_size == 0) {
+    ::close(fd);
+    throw notMazeFile(filename, "empty");
+  }
+  fileSize = status.st_size;
+  void *mapping = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd); // the mapping keeps the file open
+  if (mapping == MAP_FAILED)
+    throw std::runtime_error("Could not map " + filename + ".");
+  _mapping = mapping;
+  _mappingSize = fileSize;
+  file = static_cast<const unsigned char *>(mapping);
+#else
+  std::ifstream in(filename, std::ios::binary);
+  if (!in)
+    throw std::runtime_error("Could not open " + filename + ".");
+  _contents.assign(std::istreambuf_iterator<char>(in),
+                   std::istreambuf_iterator<char>());
+  fileSize = _contents.size();
+  file = _contents.data();
+#endif
+
+  try {
+    _info = parseHeader(file, fileSize, filename);
+  } catch (...) {
+    close();
+    throw;
+  }
+  _view = MazeView(file + MAZE_FILE_DATA_OFFSET, _info.width, _info.height);
+}
+
+
+MazeFile::~MazeFile() { close(); }
+
+
+MazeFile::MazeFile(MazeFile &&other) noexcept
+    : _info(other._info), _view(other._view), _mapping(other._mapping),
+      _mappingSize(other._mappingSize), _contents(std::move(other._contents)) {
+  other._mapping = nullptr;
+  other._mappingSize = 0;
+  other._view = MazeView();
+}
+
+
+MazeFile &MazeFile::operator=(MazeFile &&other) noexcept {
+  if (this != &other) {
+    close();
+    _info = other._info;
+    _view = other._view;
+    _mapping = std::exchange(other._mapping, nullptr);
+    _mappingSize = std::exchange(other._mappingSize, 0);
+    _contents = std::move(other._contents);
+    other._view = MazeView();
+  }
+  return *this;
+}
+
+
+void MazeFile::close() {
+#ifdef MAZEFILE_MMAP
+  if (_mapping)
+    munmap(_mapping, _mappingSize);
+#endif
+  _mapping = nullptr;
+  _mappingSize = 0;
+  _contents.clear();
+  _view = MazeView();
+}
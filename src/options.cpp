@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "../include/options.h"
+
+namespace {
+
+/**
+   Reads the value following option argv[i] and advances i past it.
+*/
+std::string value(int argc, char *argv[], int &i) {
+  if (i + 1 >= argc)
+    throw std::runtime_error(std::string("Missing value for ") + argv[i] +
+                             ".");
+  return argv[++i];
+}
+
+int intValue(int argc, char *argv[], int &i, int min) {
+  const std::string option = argv[i];
+  const std::string text = value(argc, argv, i);
+  size_t end = 0;
+  int result;
+  try {
+    result = std::stoi(text, &end);
+  } catch (const std::exception &) {
+    end = 0;
+  }
+  if (end == 0 || end != text.size())
+    throw std::runtime_error("Expected a number for " + option + ", got '" +
+                             text + "'.");
+  if (result < min)
+    throw std::runtime_error(option + " must be at least " +
+                             std::to_string(min) + ".");
+  return result;
+}
+
+uint64_t seedValue(int argc, char *argv[], int &i) {
+  const std::string option = argv[i];
+  const std::string text = value(argc, argv, i);
+  size_t end = 0;
+  uint64_t result = 0;
+  try {
+    result = std::stoull(text, &end);
+  } catch (const std::exception &) {
+    end = 0;
+  }
+  if (end == 0 || end != text.size())
+    throw std::runtime_error("Expected a number for " + option + ", got '" +
+                             text + "'.");
+  return result;
+}
+
+} // namespace
+
+
+Options parseOptions(int argc, char *argv[]) {
+  Options options;
+
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+
+    if (arg == "--help") {
+      options.help = true;
+    } else if (arg == "--width") {
+      options.width = intValue(argc, argv, i, 5);
+    } else if (arg == "--height") {
+      options.height = intValue(argc, argv, i, 5);
+    } else if (arg == "--algorithm") {
+      options.algorithm = parseAlgorithm(value(argc, argv, i));
+    } else if (arg == "--solver") {
+      const std::string solver = value(argc, argv, i);
+      if (solver != "dfs" && solver != "none")
+        throw std::runtime_error("Unknown solver '" + solver +
+                                 "', expected dfs|none.");
+      options.solve = solver == "dfs";
+    } else if (arg == "--seed") {
+      options.seed = seedValue(argc, argv, i);
+      options.hasSeed = true;
+    } else if (arg == "--threads") {
+      options.threads = intValue(argc, argv, i, 0);
+    } else if (arg == "--scale") {
+      options.scale = intValue(argc, argv, i, 1);
+    } else if (arg == "--color") {
+      const std::string style = value(argc, argv, i);
+      if (style != "gray" && style != "distance")
+        throw std::runtime_error("Unknown color '" + style +
+                                 "', expected gray|distance.");
+      options.style =
+          style == "gray" ? RenderStyle::GRAY : RenderStyle::DISTANCE;
+    } else if (arg == "--output") {
+      options.output = value(argc, argv, i);
+    } else if (arg == "--format") {
+      const std::string format = value(argc, argv, i);
+      if (format == "png")
+        options.format = OutputFormat::PNG;
+      else if (format == "maze")
+        options.format = OutputFormat::MAZE;
+      else if (format == "tiles")
+        options.format = OutputFormat::TILES;
+      else
+        throw std::runtime_error("Unknown format '" + format +
+                                 "', expected png|maze|tiles.");
+    } else if (arg == "--input") {
+      options.input = value(argc, argv, i);
+    } else if (arg == "--storage") {
+      const std::string storage = value(argc, argv, i);
+      if (storage != "memory" && storage != "mapped")
+        throw std::runtime_error("Unknown storage '" + storage +
+                                 "', expected memory|mapped.");
+      options.storage =
+          storage == "memory" ? GridStorage::MEMORY : GridStorage::MAPPED;
+    } else if (arg == "--no-output") {
+      options.noOutput = true;
+    } else if (arg == "--timer") {
+      options.timer = true;
+    } else if (arg == "--counters") {
+      options.counters = true;
+    } else if (arg == "--memory") {
+      options.memory = true;
+    } else if (arg == "--trace") {
+      options.trace = value(argc, argv, i);
+    } else if (arg == "--batch") {
+      options.batchCount = intValue(argc, argv, i, 1);
+    } else if (arg == "--min-size") {
+      options.minSize = intValue(argc, argv, i, 5);
+    } else if (arg == "--max-size") {
+      options.maxSize = intValue(argc, argv, i, 5);
+    } else {
+      throw std::runtime_error("Unknown option '" + arg + "'.");
+    }
+  }
+
+  if (options.minSize > options.maxSize)
+    throw std::runtime_error("--min-size must not exceed --max-size.");
+  if ((options.minSize | 1) > options.maxSize)
+    throw std::runtime_error("--min-size and --max-size must include an odd "
+                             "size.");
+  if (options.batchCount > 0 &&
+      (options.format != OutputFormat::PNG || !options.input.empty()))
+    throw std::runtime_error("--batch writes PNGs of new mazes only.");
+  if (options.format == OutputFormat::TILES &&
+      options.style != RenderStyle::GRAY)
+    throw std::runtime_error("--format tiles draws gray mazes only.");
+  if (options.batchCount > 0 && options.storage != GridStorage::MEMORY)
+    throw std::runtime_error("--batch keeps its grids in memory.");
+  // a PNG is scale pixels per grid cell each way, and Picture counts them
+  // in int; the tile pyramid counts in 64 bits and has no such limit
+  const int side =
+      options.batchCount > 0 ? options.maxSize
+                             : std::max(options.width, options.height) | 1;
+  if (options.format == OutputFormat::PNG &&
+      int64_t(side) * options.scale > INT_MAX)
+    throw std::runtime_error("--scale " + std::to_string(options.scale) +
+                             " makes a picture more than " +
+                             std::to_string(INT_MAX) + " pixels across.");
+
+  return options;
+}
+
+
+void printUsage(const char *program, std::ostream &out) {
+  out << "usage: " << program << " [options]\n"
+      << "\n"
+      << "  --width N          grid width, walls included (default 101)\n"
+      << "  --height N         grid height, walls included (default 101)\n"
+      << "  --algorithm NAME   " << algorithmNames()
+      << " (default backtracker)\n"
+      << "  --solver NAME      dfs|none (default dfs)\n"
+      << "  --seed N           random seed (default: current time)\n"
+      << "  --scale N          output pixels per grid cell (default 1)\n"
+      << "  --color NAME       gray|distance; distance shades every open\n"
+      << "                     pixel by its distance from the entrance\n"
+      << "                     (default gray)\n"
+      << "  --output PATH      output file (default maze.png or maze.maze);\n"
+      << "                     - writes the PNG to standard output; the\n"
+      << "                     base name of the pyramid for tiles\n"
+      << "                     (default maze); a directory in batch mode,\n"
+      << "                     where it defaults to none\n"
+      << "  --format NAME      png|maze|tiles (default png); maze writes the\n"
+      << "                     walls in the compact binary .maze format,\n"
+      << "                     tiles a Deep Zoom pyramid of 256x256 PNG\n"
+      << "                     tiles: PATH.dzi and PATH_files/\n"
+      << "  --input FILE       load a .maze file instead of generating one\n"
+      << "  --storage NAME     memory|mapped (default memory); mapped keeps\n"
+      << "                     the grid in a sparse temporary file in\n"
+      << "                     $TMPDIR (default /var/tmp) that the kernel\n"
+      << "                     pages, for mazes larger than memory\n"
+      << "  --no-output        generate and solve only, write nothing\n"
+      << "  --timer            print the time spent in each stage, to\n"
+      << "                     standard error with --output -\n"
+      << "  --counters         add hardware counters (IPC, cache, branch and\n"
+      << "                     dTLB misses per cell) to --timer, Linux only\n"
+      << "  --memory           add allocations, bytes and peak live heap per\n"
+      << "                     stage to --timer\n"
+      << "  --trace FILE       write every timed scope per thread to FILE as\n"
+      << "                     Chrome trace JSON at exit\n"
+      << "\n"
+      << "  --batch N          make N mazes of random size; maze i uses\n"
+      << "                     seed + i\n"
+      << "  --min-size N       smallest batch maze side (default 51)\n"
+      << "  --max-size N       largest batch maze side (default 501)\n"
+      << "  --threads N        batch or tile worker threads (default: all\n"
+      << "                     cores)\n";
+}
@@ -1,37 +1,56 @@
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <stdexcept>
+#include <thread>
+#include <utility>
 #include <vector>
 
-#include "../include/Color_Space.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "../include/Timer.h"
+#include "../include/allocation.h"
 #include "../include/lodepng.h"
 #include "../include/picture.h"
 
+namespace {
+
+// the color of the int channel arguments, which keep only their low 8 bits
+// as they always have
+clrspc::Rgb8 toRgb8(int red, int green, int blue) {
+  return {static_cast<uint8_t>(red), static_cast<uint8_t>(green),
+          static_cast<uint8_t>(blue)};
+}
+
+} // namespace
+
 Picture::Picture() {
   _width = 0;
   _height = 0;
+  _stride = 0;
 }
 
 Picture::Picture(int width, int height, int red, int green, int blue)
     : _values(width * height * 4) {
   _width = width;
   _height = height;
-  for (size_t k = 0; k < _values.size(); k += 4) {
-    _values[k] = red;
-    _values[k + 1] = green;
-    _values[k + 2] = blue;
-    _values[k + 3] = 255;
-  }
+  _stride = width;
+  fillPixels(0, _values.size(), toRgb8(red, green, blue));
 }
 
 Picture::Picture(const vector<vector<int>> &grays) {
   if (grays.size() == 0 || grays[0].size() == 0) {
     _width = 0;
     _height = 0;
+    _stride = 0;
   } else {
     _values = vector<unsigned char>(grays[0].size() * grays.size() * 4);
     _width = grays[0].size();
     _height = grays.size();
+    _stride = _width;
     int k = 0;
     for (int y = 0; y < _height; y++)
       for (int x = 0; x < _width; x++) {
@@ -45,62 +64,186 @@ Picture::Picture(const vector<vector<int>> &grays) {
   }
 }
 
+namespace {
+
+// lodepng's zlib step, under its own zone so that --timer splits an encode
+// into the deflate and, as the rest, the scanline filtering
+unsigned timedZlib(unsigned char **out, size_t *outsize,
+                   const unsigned char *in, size_t insize,
+                   const LodePNGCompressSettings *settings) {
+  TIMER_ZONE("png deflate");
+  LodePNGCompressSettings builtin = *settings;
+  builtin.custom_zlib = nullptr;
+  return lodepng_zlib_compress(out, outsize, in, insize, &builtin);
+}
+
+} // namespace
+
 Picture::Picture(string filename) {
+  TIMER_ZONE("png decode");
   unsigned int w, h;
   unsigned error = lodepng::decode(_values, w, h, filename.c_str());
   if (error != 0)
     throw runtime_error(lodepng_error_text(error));
   _width = w;
   _height = h;
+  _stride = w;
 }
 
 void Picture::save(string filename) const {
-  unsigned error = lodepng::encode(filename.c_str(), _values, _width, _height);
+  const PngData png = encode();
+  unsigned error = lodepng_save_file(png.data(), png.size(), filename.c_str());
+  if (error != 0)
+    throw runtime_error(lodepng_error_text(error));
+}
+
+void Picture::encode(vector<unsigned char> &out) const {
+  const PngData png = encode();
+  out.assign(png.begin(), png.end());
+}
+
+void Picture::encode(const PngWriter &write) const {
+  const PngData png = encode();
+  write(png.bytes());
+}
+
+PngData Picture::encode() const {
+  // lodepng::encode() would copy the result into a vector; the C call
+  // hands over its own buffer
+  TIMER_ZONE("png encode");
+  vector<unsigned char> scratch;
+  lodepng::State state;
+  state.encoder.zlibsettings.custom_zlib = timedZlib;
+  unsigned char *data = nullptr;
+  size_t size = 0;
+  unsigned error =
+      lodepng_encode(&data, &size, packed(scratch), _width, _height, &state);
+  PngData png(data, size);
   if (error != 0)
     throw runtime_error(lodepng_error_text(error));
+  return png;
+}
+
+PngData::~PngData() { lodepng_free(_data); }
+
+PngData::PngData(PngData &&other) noexcept
+    : _data(exchange(other._data, nullptr)), _size(exchange(other._size, 0)) {}
+
+PngData &PngData::operator=(PngData &&other) noexcept {
+  if (this != &other) {
+    lodepng_free(_data);
+    _data = exchange(other._data, nullptr);
+    _size = exchange(other._size, 0);
+  }
+  return *this;
+}
+
+void Picture::assign(int width, int height, int red, int green, int blue) {
+  _values.resize(4 * size_t(width) * height);
+  _width = width;
+  _height = height;
+  _stride = width;
+  fillPixels(0, _values.size(), toRgb8(red, green, blue));
+}
+
+void Picture::resize(int width, int height) {
+  _values.resize(4 * size_t(width) * height);
+  _width = width;
+  _height = height;
+  _stride = width;
 }
 
 int Picture::red(int x, int y) const {
   if (0 <= x && x < _width && 0 <= y && y < _height)
-    return _values[4 * (y * _width + x)];
+    return row(y)[4 * x];
   else
     return 0;
 }
 
 int Picture::green(int x, int y) const {
   if (0 <= x && x < _width && 0 <= y && y < _height)
-    return _values[4 * (y * _width + x) + 1];
+    return row(y)[4 * x + 1];
   else
     return 0;
 }
 
 int Picture::blue(int x, int y) const {
   if (0 <= x && x < _width && 0 <= y && y < _height)
-    return _values[4 * (y * _width + x) + 2];
+    return row(y)[4 * x + 2];
   else
     return 0;
 }
 
+clrspc::Rgb8 Picture::pixel(int x, int y) const {
+  if (0 <= x && x < _width && 0 <= y && y < _height) {
+    const unsigned char *pixel = row(y) + 4 * x;
+    return {pixel[0], pixel[1], pixel[2]};
+  } else
+    return {0, 0, 0};
+}
+
 void Picture::set(int x, int y, int red, int green, int blue) {
+  set(x, y, toRgb8(red, green, blue));
+}
+
+void Picture::set(int x, int y, clrspc::Rgb8 color) {
   if (x >= 0 && y >= 0) {
     ensure(x, y);
-    int k = 4 * (y * _width + x);
-    _values[k] = red;
-    _values[k + 1] = green;
-    _values[k + 2] = blue;
-    _values[k + 3] = 255;
+    const uint32_t word = clrspc::to_rgba_word(color);
+    memcpy(row(y) + 4 * size_t(x), &word, 4);
+  }
+}
+
+void Picture::fillSpan(int x, int y, int length, int red, int green,
+                       int blue) {
+  fillRect(x, y, length, 1, toRgb8(red, green, blue));
+}
+
+void Picture::fillSpan(int x, int y, int length, clrspc::Rgb8 color) {
+  fillRect(x, y, length, 1, color);
+}
+
+void Picture::fillRect(int x, int y, int width, int height, int red,
+                       int green, int blue) {
+  fillRect(x, y, width, height, toRgb8(red, green, blue));
+}
+
+void Picture::fillRect(int x, int y, int width, int height,
+                       clrspc::Rgb8 color) {
+  const int left = max(x, 0);
+  const int top = max(y, 0);
+  const int right = x + width;
+  const int bottom = y + height;
+  if (left >= right || top >= bottom)
+    return;
+  ensure(right - 1, bottom - 1);
+
+  for (int dy = top; dy < bottom; dy++) {
+    const size_t start = 4 * (size_t(dy) * _stride + left);
+    fillPixels(start, start + 4 * size_t(right - left), color);
   }
 }
 
 void Picture::add(const Picture &other, int x, int y) {
+  const int skipX = max(-x, 0);
+  const int skipY = max(-y, 0);
+  if (skipX >= other._width || skipY >= other._height)
+    return;
   ensure(x + other._width - 1, y + other._height - 1);
-  int k = 0;
-  for (int dy = 0; dy < other._height; dy++)
-    for (int dx = 0; dx < other._width; dx++) {
-      set(x + dx, y + dy, other._values[k], other._values[k + 1],
-          other._values[k + 2]);
-      k += 4;
+
+  // the color of each pixel, made opaque as set() would
+  const uint32_t opaque = clrspc::to_rgba_word({0, 0, 0});
+  const int width = other._width - skipX;
+  for (int dy = skipY; dy < other._height; dy++) {
+    const unsigned char *in = other.row(dy) + 4 * size_t(skipX);
+    unsigned char *out = row(y + dy) + 4 * size_t(x + skipX);
+    for (int i = 0; i < width; i++, in += 4, out += 4) {
+      uint32_t word;
+      memcpy(&word, in, 4);
+      word |= opaque;
+      memcpy(out, &word, 4);
     }
+  }
 }
 
 vector<vector<int>> Picture::grays() const {
@@ -108,98 +251,281 @@ vector<vector<int>> Picture::grays() const {
   for (int y = 0; y < _height; y++) {
     result[y] = vector<int>(_width);
     for (int x = 0; x < _width; x++) {
-      int k = 4 * (y * _width + x);
-      result[y][x] = (int)(0.2126 * _values[k] + 0.7152 * _values[k + 1] +
-                           0.0722 * _values[k + 2]);
+      const unsigned char *pixel = row(y) + 4 * x;
+      result[y][x] = (int)(0.2126 * pixel[0] + 0.7152 * pixel[1] +
+                           0.0722 * pixel[2]);
+    }
+  }
+  return result;
+}
+
+namespace {
+
+/**
+   Where one output pixel samples its axis: the pixels at index and
+   index + 1 of the source, weighted (256 - weight) : weight in 8.8 fixed
+   point. index + 1 always exists; a source of a single pixel uses index
+   0 twice.
+ */
+struct Tap {
+  int index;
+  int weight;
+};
+
+/**
+   Maps out output positions evenly onto in source positions, first onto
+   first and last onto last, as the float resize did.
+ */
+vector<Tap> taps(int in, int out) {
+  vector<Tap> result(out);
+  const int64_t span = max(out - 1, 1);
+  for (int i = 0; i < out; i++) {
+    const int64_t position = int64_t(i) * (in - 1);
+    int index = int(position / span);
+    int weight = int(((position % span) * 256 + span / 2) / span);
+    if (weight == 256) {
+      index++;
+      weight = 0;
     }
+    if (index >= in - 1 && in > 1) { // the last pixel, as a full-weight index + 1
+      index = in - 2;
+      weight = 256;
+    }
+    result[i] = {max(index, 0), weight};
   }
   return result;
 }
 
+/**
+   Interpolates one source row horizontally into out 16-bit channels per
+   pixel, (a * (256 - w) + b * w) / 2, which keeps 7 fraction bits and
+   stays below 2^15 for the signed SIMD multiplies of the vertical pass.
+ */
+void resizeRow(const unsigned char *src, int inWidth, const vector<Tap> &xTaps,
+               int16_t *out) {
+  const int outWidth = int(xTaps.size());
+  int j = 0;
+#ifdef __SSE2__
+  if (inWidth > 1) {
+    const __m128i zero = _mm_setzero_si128();
+    for (; j < outWidth; j++) {
+      const Tap tap = xTaps[j];
+      // a.rgba b.rgba as 16-bit lanes, then interleaved a.r b.r a.g b.g ...
+      const __m128i pair = _mm_unpacklo_epi8(
+          _mm_loadl_epi64((const __m128i *)(src + 4 * tap.index)), zero);
+      const __m128i channels =
+          _mm_unpacklo_epi16(pair, _mm_srli_si128(pair, 8));
+      const __m128i weights =
+          _mm_set1_epi32(((tap.weight) << 16) | (256 - tap.weight));
+      const __m128i sums =
+          _mm_srli_epi32(_mm_madd_epi16(channels, weights), 1);
+      _mm_storel_epi64((__m128i *)(out + 4 * j), _mm_packs_epi32(sums, sums));
+    }
+  }
+#endif
+  for (; j < outWidth; j++) {
+    const Tap tap = xTaps[j];
+    const unsigned char *a = src + 4 * tap.index;
+    const unsigned char *b = inWidth > 1 ? a + 4 : a;
+    for (int k = 0; k < 4; k++)
+      out[4 * j + k] = (a[k] * (256 - tap.weight) + b[k] * tap.weight) >> 1;
+  }
+}
+
+/**
+   Blends two horizontally resized rows with vertical weight w and rounds
+   to 8 bits: (top * (256 - w) + bottom * w) / 2^15, opaque.
+ */
+void blendRows(const int16_t *top, const int16_t *bottom, int weight,
+               int outWidth, unsigned char *out) {
+  const int values = 4 * outWidth;
+  int k = 0;
+#ifdef __SSE2__
+  const __m128i weights = _mm_set1_epi32((weight << 16) | (256 - weight));
+  const __m128i half = _mm_set1_epi32(1 << 14);
+  const __m128i opaque = _mm_set1_epi32(int(0xff000000));
+  for (; k + 16 <= values; k += 16) {
+    __m128i packed[2];
+    for (int h = 0; h < 2; h++) {
+      const __m128i a = _mm_loadu_si128((const __m128i *)(top + k + 8 * h));
+      const __m128i b = _mm_loadu_si128((const __m128i *)(bottom + k + 8 * h));
+      const __m128i low = _mm_srai_epi32(
+          _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(a, b), weights), half),
+          15);
+      const __m128i high = _mm_srai_epi32(
+          _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(a, b), weights), half),
+          15);
+      packed[h] = _mm_packs_epi32(low, high);
+    }
+    _mm_storeu_si128((__m128i *)(out + k),
+                     _mm_or_si128(_mm_packus_epi16(packed[0], packed[1]), opaque));
+  }
+#endif
+  for (; k < values; k++) {
+    out[k] = (k & 3) == 3 ? 255
+                          : (top[k] * (256 - weight) + bottom[k] * weight +
+                             (1 << 14)) >> 15;
+  }
+}
+
+} // namespace
+
 Picture Picture::bilinearResize(float factor) const {
   if (factor == 1)
     return *this;
 
-  // returns a rgb struct not associated with the ImageEditor class.
-  auto getRgb = [&](int x, int y) -> const clrspc::Rgb {
-    return {static_cast<float>(red(x, y)), static_cast<float>(green(x, y)),
-            static_cast<float>(blue(x, y))};
+  const int inHeight = _height;
+  const int inWidth = _width;
+  const int outHeight = static_cast<int>(round(inHeight * factor));
+  const int outWidth = static_cast<int>(round(inWidth * factor));
+
+  if (inWidth == 0 || inHeight == 0 || outWidth == 0 || outHeight == 0)
+    return Picture(outWidth, outHeight, 0, 0, 0);
+
+  // every byte is written below, so skip the constructor's fill
+  Picture newPic;
+  newPic._values.resize(4 * size_t(outWidth) * outHeight);
+  newPic._width = outWidth;
+  newPic._height = outHeight;
+  newPic._stride = outWidth;
+
+  const vector<Tap> xTaps = taps(inWidth, outWidth);
+  const vector<Tap> yTaps = taps(inHeight, outHeight);
+
+  // Each worker resizes its band of output rows, keeping the two source
+  // rows it last resized horizontally for the next output row.
+  auto resizeBand = [&](int firstRow, int lastRow) {
+    vector<int16_t> rows[2] = {vector<int16_t>(4 * size_t(outWidth) + 8),
+                               vector<int16_t>(4 * size_t(outWidth) + 8)};
+    int cached[2] = {-1, -1};
+    for (int i = firstRow; i < lastRow; i++) {
+      const Tap tap = yTaps[i];
+      const int sources[2] = {tap.index, min(tap.index + 1, inHeight - 1)};
+      int16_t *resized[2];
+      for (int s = 0; s < 2; s++) {
+        int slot = cached[0] == sources[s] ? 0 : cached[1] == sources[s] ? 1 : -1;
+        if (slot < 0) {
+          slot = cached[0] == sources[1 - s] ? 1 : 0;
+          resizeRow(row(sources[s]), inWidth, xTaps, rows[slot].data());
+          cached[slot] = sources[s];
+        }
+        resized[s] = rows[slot].data();
+      }
+      blendRows(resized[0], resized[1], tap.weight, outWidth, newPic.row(i));
+    }
   };
 
-  const size_t inHeight = _height;
-  const size_t inWidth = _width;
-  const size_t outHeight = static_cast<int>(round(inHeight * factor));
-  const size_t outWidth = static_cast<int>(round(inWidth * factor));
-
-  const float xRatio = outWidth > 1 ? float(inWidth - 1) / (outWidth - 1) : 0;
-  const float yRatio =
-      outHeight > 1 ? float(inHeight - 1) / (outHeight - 1) : 0;
-
-  Picture newPic(outWidth, outHeight, 0, 0, 0);
-
-  for (size_t i = 0; i < outHeight; i++) {
-    for (size_t j = 0; j < outWidth; j++) {
-      const int yLow = std::floor(yRatio * i);
-      const int xLow = std::floor(xRatio * j);
-      const int xHigh = std::min(xLow + 1, int(inWidth - 1));
-      const int yHigh = std::min(yLow + 1, int(inHeight - 1));
-
-      const float yWeight = yRatio * i - yLow;
-      const float xWeight = xRatio * j - xLow;
-
-      // A,B,C, and D are known rgb values in original image
-      clrspc::Rgb A = getRgb(xLow, yLow);
-      clrspc::Rgb B = getRgb(xHigh, yLow);
-      clrspc::Rgb C = getRgb(xLow, yHigh);
-      clrspc::Rgb D = getRgb(xHigh, yHigh);
-
-      // computes a weighted average of the values associated with the four
-      // closest points
-      auto interpolate = [xWeight, yWeight](float a, float b, float c,
-                                            float d) {
-        // We first compute the interpolated value of AB and CD in the width
-        // dimension
-        const float interpolatedAB = a * (1 - xWeight) + b * xWeight;
-        const float interpolatedCD = c * (1 - xWeight) + d * xWeight;
-
-        // Then we will do linear interpolation between the points generated
-        // from the two previous interpolations above
-        return (interpolatedAB * (1.f - yWeight)) + (interpolatedCD * yWeight);
-      };
-
-      auto calcRgb = [&](const clrspc::Rgb &A, const clrspc::Rgb &B,
-                         const clrspc::Rgb &C,
-                         const clrspc::Rgb &D) -> clrspc::Rgb {
-        return {interpolate(A.r(), B.r(), C.r(), D.r()),
-                interpolate(A.g(), B.g(), C.g(), D.g()),
-                interpolate(A.b(), B.b(), C.b(), D.b())};
-      };
-
-      const auto [r, g, b] = calcRgb(A, B, C, D).get_values();
-
-      newPic.set(j, i, r, g, b);
+  const int threads = clamp<int>(int64_t(outWidth) * outHeight / (1 << 18), 1,
+                                 max(1u, thread::hardware_concurrency()));
+  vector<thread> workers;
+  for (int t = 1; t < threads; t++)
+    workers.emplace_back(resizeBand, int(int64_t(outHeight) * t / threads),
+                         int(int64_t(outHeight) * (t + 1) / threads));
+  resizeBand(0, outHeight / threads);
+  for (thread &worker : workers)
+    worker.join();
+
+  return newPic;
+}
+
+Picture Picture::scaleNearest(int factor) const {
+  return scaleNearest(factor, factor);
+}
+
+Picture Picture::scaleNearest(int xFactor, int yFactor) const {
+  if (xFactor < 1 || yFactor < 1)
+    throw invalid_argument("Scale factors must be at least 1.");
+
+  Picture newPic;
+  newPic._width = _width * xFactor;
+  newPic._height = _height * yFactor;
+  newPic._stride = newPic._width;
+  newPic._values.resize(4 * size_t(newPic._width) * newPic._height);
+
+  const size_t rowBytes = 4 * size_t(newPic._width);
+  for (int y = 0; y < _height; y++) {
+    const unsigned char *in = row(y);
+    unsigned char *first = newPic.row(y * yFactor);
+    unsigned char *out = first;
+    for (int x = 0; x < _width; x++, in += 4) {
+      uint32_t pixel;
+      memcpy(&pixel, in, 4);
+      for (int dx = 0; dx < xFactor; dx++, out += 4)
+        memcpy(out, &pixel, 4);
     }
+    for (int dy = 1; dy < yFactor; dy++)
+      memcpy(newPic.row(y * yFactor + dy), first, rowBytes);
   }
-
   return newPic;
-};
+}
+
+void Picture::reserve(int width, int height) {
+  const int rows = _stride ? int(_values.size() / (4 * size_t(_stride))) : 0;
+  if (width > _stride || height > rows)
+    reallocate(max(width, _stride), max(height, rows));
+}
 
 /**
-   Ensures that the given point exists.
+   Ensures that the given point exists, filling new pixels with white.
+   Capacity at least doubles along an axis that runs out, so growing a
+   picture one row or column at a time takes amortized linear time.
  */
 void Picture::ensure(int x, int y) {
   if (x >= _width || y >= _height) {
-    int new_width = max(x + 1, _width);
-    int new_height = max(y + 1, _height);
-    vector<unsigned char> new_values(4 * new_width * new_height);
-    fill(new_values.begin(), new_values.end(), 255); // fill with white
-    int j = 0;
-    for (int dy = 0; dy < _height; dy++)
-      for (int dx = 0; dx < _width; dx++)
-        for (int k = 0; k < 4; k++, j++)
-          new_values[4 * (dy * new_width + dx) + k] = _values[j];
-    _values.swap(new_values);
+    const int new_width = max(x + 1, _width);
+    const int new_height = max(y + 1, _height);
+    const int rows = _stride ? int(_values.size() / (4 * size_t(_stride))) : 0;
+    if (new_width > _stride || new_height > rows)
+      reallocate(new_width > _stride ? max(new_width, 2 * _stride) : _stride,
+                 new_height > rows ? max(new_height, 2 * rows) : rows);
+
+    fillWhite(_width, 0, new_width, _height);
+    fillWhite(0, _height, new_width, new_height);
     _width = new_width;
     _height = new_height;
   }
 }
+
+/**
+   Moves the pixels into a buffer of the given number of rows of the given
+   stride, one memcpy per row.
+ */
+void Picture::reallocate(int stride, int rows) {
+  vector<unsigned char> new_values(4 * size_t(stride) * rows);
+  for (int y = 0; y < _height; y++)
+    memcpy(new_values.data() + 4 * size_t(y) * stride, row(y),
+           4 * size_t(_width));
+  _values.swap(new_values);
+  _stride = stride;
+}
+
+void Picture::fillWhite(int left, int top, int right, int bottom) {
+  if (left < right)
+    for (int y = top; y < bottom; y++)
+      memset(row(y) + 4 * size_t(left), 255, 4 * size_t(right - left));
+}
+
+/**
+   Sets the pixels from byte offset begin up to end to one color, storing
+   each as a single word.
+ */
+void Picture::fillPixels(size_t begin, size_t end, clrspc::Rgb8 color) {
+  const uint32_t word = clrspc::to_rgba_word(color);
+  for (size_t k = begin; k < end; k += 4)
+    memcpy(_values.data() + k, &word, 4);
+}
+
+/**
+   Returns the pixels as the tightly packed rows lodepng expects: the
+   buffer itself unless the picture has spare columns, otherwise a copy in
+   scratch.
+ */
+const unsigned char *Picture::packed(vector<unsigned char> &scratch) const {
+  if (_stride == _width)
+    return _values.data();
+  scratch.resize(4 * size_t(_width) * _height);
+  for (int y = 0; y < _height; y++)
+    memcpy(scratch.data() + 4 * size_t(y) * _width, row(y),
+           4 * size_t(_width));
+  return scratch.data();
+}
@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "../include/maze.h"
+#include "../include/picture.h"
+#include "../include/tilepyramid.h"
+
+namespace {
+
+/**
+   The size of every level of a pyramid over a full-resolution image,
+   from level 0 (one pixel) up to maxLevel (the image).
+*/
+struct Levels {
+  Levels(int64_t width, int64_t height, int tileSize) : tileSize(tileSize) {
+    int64_t side = std::max(width, height);
+    maxLevel = 0;
+    while ((int64_t(1) << maxLevel) < side)
+      maxLevel++;
+    for (int level = 0; level <= maxLevel; level++) {
+      const int shift = maxLevel - level;
+      widths.push_back(int((width + (int64_t(1) << shift) - 1) >> shift));
+      heights.push_back(int((height + (int64_t(1) << shift) - 1) >> shift));
+    }
+  }
+
+  int columns(int level) const {
+    return (widths[level] + tileSize - 1) / tileSize;
+  }
+  int rows(int level) const {
+    return (heights[level] + tileSize - 1) / tileSize;
+  }
+  int64_t tiles(int level) const { return int64_t(columns(level)) * rows(level); }
+
+  // pixels of the tile starting at offset along a level side of length side
+  int extent(int side, int index) const {
+    return std::min(tileSize, side - index * tileSize);
+  }
+
+  int tileSize;
+  int maxLevel;
+  std::vector<int> widths;
+  std::vector<int> heights;
+};
+
+/**
+   Halves four neighboring tiles of one level into a tile of the level
+   below with a 2x2 box filter. quad holds the top left, top right, bottom
+   left and bottom right tile, with nullptr for those past the edge of the
+   level. A box cut off by the edge of the level averages the pixels it
+   has.
+*/
+void boxFilter(const std::array<const Picture *, 4> &quad, Picture &out,
+               int width, int height, int tileSize) {
+  out.assign(width, height, 0, 0, 0);
+  for (int y = 0; y < height; y++) {
+    const int bottom = 2 * y >= tileSize;
+    const int ly = 2 * y - bottom * tileSize;
+    unsigned char *o = out.row(y);
+    for (int x = 0; x < width; x++, o += 4) {
+      const int right = 2 * x >= tileSize;
+      const int lx = 2 * x - right * tileSize;
+      const Picture &tile = *quad[2 * bottom + right];
+
+      // a missing column or row repeats the one present, which weighs the
+      // pixels that are there equally
+      const unsigned char *p0 = tile.row(ly) + 4 * lx;
+      const unsigned char *p1 =
+          ly + 1 < tile.height() ? tile.row(ly + 1) + 4 * lx : p0;
+      const int next = lx + 1 < tile.width() ? 4 : 0;
+      for (int c = 0; c < 3; c++)
+        o[c] = (p0[c] + p0[c + next] + p1[c] + p1[c + next] + 2) >> 2;
+      o[3] = 255;
+    }
+  }
+}
+
+struct Worker {
+  std::vector<std::array<Picture, 4>> children; // scratch tiles per level
+  TilePyramidStats stats;
+};
+
+class PyramidRenderer {
+public:
+  PyramidRenderer(const Grid &grid, const TilePyramidOptions &options,
+                  const TileSink &sink)
+      : _grid(grid), _scale(options.scale), _sink(sink),
+        _levels(int64_t(grid.width()) * options.scale,
+                int64_t(grid.height()) * options.scale, options.tileSize) {}
+
+  const Levels &levels() const { return _levels; }
+
+  /**
+     Renders tile (col, row) of a level into out, after rendering, and
+     emitting, the tiles it is filtered from.
+  */
+  void build(int level, int col, int row, Picture &out, Worker &worker) const {
+    const int tileSize = _levels.tileSize;
+    const int width = _levels.extent(_levels.widths[level], col);
+    const int height = _levels.extent(_levels.heights[level], row);
+
+    if (level == _levels.maxLevel) {
+      renderMazeRegion(_grid, out, _scale, col * tileSize, row * tileSize,
+                       width, height);
+    } else {
+      std::array<Picture, 4> &children = worker.children[level + 1];
+      std::array<const Picture *, 4> quad{};
+      for (int k = 0; k < 4; k++) {
+        const int childCol = 2 * col + (k & 1);
+        const int childRow = 2 * row + (k >> 1);
+        if (childCol < _levels.columns(level + 1) &&
+            childRow < _levels.rows(level + 1)) {
+          build(level + 1, childCol, childRow, children[k], worker);
+          quad[k] = &children[k];
+        }
+      }
+      boxFilter(quad, out, width, height, tileSize);
+    }
+    emit(level, col, row, out, worker);
+  }
+
+  void emit(int level, int col, int row, const Picture &tile,
+            Worker &worker) const {
+    const PngData png = tile.encode();
+    _sink(level, col, row, png.bytes());
+    worker.stats.tiles++;
+    worker.stats.bytes += png.size();
+  }
+
+private:
+  const Grid &_grid;
+  int _scale;
+  const TileSink &_sink;
+  Levels _levels;
+};
+
+} // namespace
+
+
+TilePyramidStats renderTilePyramid(const Grid &grid,
+                                   const TilePyramidOptions &options,
+                                   const TileSink &sink) {
+  if (options.tileSize < 2 || (options.tileSize & (options.tileSize - 1)))
+    throw std::invalid_argument("Tile size must be a power of two of at "
+                                "least 2.");
+  if (options.scale < 1)
+    throw std::invalid_argument("Scale must be at least 1.");
+  if (grid.width() < 1 || grid.height() < 1)
+    throw std::invalid_argument("Cannot tile an empty grid.");
+
+  const PyramidRenderer renderer(grid, options, sink);
+  const Levels &levels = renderer.levels();
+
+  int threads = options.threads;
+  if (threads <= 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+
+  // Workers take the subtrees under the first level with a few tiles per
+  // thread, so they stay busy while the last ones finish; the levels above
+  // are a few tiles and filtered here.
+  int cut = levels.maxLevel;
+  for (int level = 0; level < levels.maxLevel; level++) {
+    if (levels.tiles(level) >= 4 * int64_t(threads)) {
+      cut = level;
+      break;
+    }
+  }
+  const int jobs = int(levels.tiles(cut));
+  threads = std::min(threads, jobs);
+
+  std::vector<Worker> workers(threads);
+  for (Worker &worker : workers)
+    worker.children.resize(levels.maxLevel + 1);
+  std::vector<Picture> below(jobs);
+  std::atomic<int> nextJob(0);
+  std::exception_ptr failure;
+  std::mutex failureMutex;
+
+  auto work = [&](Worker &worker) {
+    try {
+      for (int job = nextJob++; job < jobs; job = nextJob++)
+        renderer.build(cut, job % levels.columns(cut), job / levels.columns(cut),
+                       below[job], worker);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(failureMutex);
+      if (!failure)
+        failure = std::current_exception();
+      nextJob = jobs; // stop handing out jobs
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (int i = 1; i < threads; i++)
+    pool.emplace_back(work, std::ref(workers[i]));
+  work(workers[0]);
+  for (auto &thread : pool)
+    thread.join();
+
+  if (failure)
+    std::rethrow_exception(failure);
+
+  for (int level = cut - 1; level >= 0; level--) {
+    const int columns = levels.columns(level);
+    std::vector<Picture> tiles(levels.tiles(level));
+    for (int row = 0; row < levels.rows(level); row++) {
+      for (int col = 0; col < columns; col++) {
+        std::array<const Picture *, 4> quad{};
+        for (int k = 0; k < 4; k++) {
+          const int childCol = 2 * col + (k & 1);
+          const int childRow = 2 * row + (k >> 1);
+          if (childCol < levels.columns(level + 1) &&
+              childRow < levels.rows(level + 1))
+            quad[k] = &below[childRow * levels.columns(level + 1) + childCol];
+        }
+        Picture &tile = tiles[row * columns + col];
+        boxFilter(quad, tile, levels.extent(levels.widths[level], col),
+                  levels.extent(levels.heights[level], row),
+                  levels.tileSize);
+        renderer.emit(level, col, row, tile, workers[0]);
+      }
+    }
+    below = std::move(tiles);
+  }
+
+  TilePyramidStats stats;
+  stats.levels = levels.maxLevel + 1;
+  for (const Worker &worker : workers) {
+    stats.tiles += worker.stats.tiles;
+    stats.bytes += worker.stats.bytes;
+  }
+  return stats;
+}
+
+
+TilePyramidStats writeTilePyramid(const Grid &grid, const std::string &base,
+                                  const TilePyramidOptions &options) {
+  const std::string directory = base + "_files";
+  const Levels levels(int64_t(grid.width()) * options.scale,
+                      int64_t(grid.height()) * options.scale,
+                      options.tileSize);
+  for (int level = 0; level <= levels.maxLevel; level++) {
+    std::error_code error;
+    std::filesystem::create_directories(
+        directory + "/" + std::to_string(level), error);
+    if (error)
+      throw std::runtime_error("Could not create " + directory + ": " +
+                               error.message() + ".");
+  }
+
+  const TilePyramidStats stats = renderTilePyramid(
+      grid, options,
+      [&](int level, int col, int row, std::span<const unsigned char> png) {
+        const std::string filename = directory + "/" + std::to_string(level) +
+                                     "/" + std::to_string(col) + "_" +
+                                     std::to_string(row) + ".png";
+        std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(png.data()), png.size());
+        out.close();
+        if (!out)
+          throw std::runtime_error("Could not write " + filename + ".");
+      });
+
+  std::ofstream dzi(base + ".dzi", std::ios::trunc);
+  dzi << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+      << "<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\"\n"
+      << "       TileSize=\"" << options.tileSize
+      << "\" Overlap=\"0\" Format=\"png\">\n"
+      << "  <Size Width=\"" << levels.widths[levels.maxLevel]
+      << "\" Height=\"" << levels.heights[levels.maxLevel] << "\"/>\n"
+      << "</Image>\n";
+  dzi.close();
+  if (!dzi)
+    throw std::runtime_error("Could not write " + base + ".dzi.");
+  return stats;
+}
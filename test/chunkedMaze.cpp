@@ -0,0 +1,109 @@
+// Checks that chunks of a ChunkedMaze agree on the edges they share, come
+// out the same from separate instances and threads, join into a connected
+// plane, and that the cache never holds more than its capacity.
+
+#include <iostream>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/ChunkedMaze.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string &what) {
+  if (!ok) {
+    std::cout << "FAIL: " << what << "\n";
+    failures++;
+  }
+}
+
+} // namespace
+
+int main() {
+  const uint64_t seed = 7;
+  const int chunkCells = 8;
+  ChunkedMaze maze(seed, chunkCells, 16);
+  const int pitch = int(maze.chunkPitch());
+
+  // shared edges: identical pixels and exactly one opening
+  bool edges = true, openings = true;
+  for (int64_t cy = -3; cy < 3; cy++) {
+    for (int64_t cx = -3; cx < 3; cx++) {
+      const auto chunk = maze.getChunk(cx, cy);
+      const auto east = maze.getChunk(cx + 1, cy);
+      const auto south = maze.getChunk(cx, cy + 1);
+      int eastOpen = 0, southOpen = 0;
+      for (int k = 0; k <= pitch; k++) {
+        edges &= chunk->at(pitch, k) == east->at(0, k);
+        edges &= chunk->at(k, pitch) == south->at(k, 0);
+        eastOpen += chunk->at(pitch, k) == VISITED;
+        southOpen += chunk->at(k, pitch) == VISITED;
+      }
+      openings &= eastOpen == 1 && southOpen == 1;
+    }
+  }
+  check(edges, "neighboring chunks agree on their shared edges");
+  check(openings, "every shared edge has exactly one opening");
+  check(maze.cachedChunks() <= 16, "the cache stays within its capacity");
+
+  // determinism across instances and cache sizes
+  ChunkedMaze other(seed, chunkCells, 1000);
+  bool same = true;
+  for (int64_t y = -100; y < 100; y++)
+    for (int64_t x = -100; x < 100; x++)
+      same &= maze.at(x, y) == other.at(x, y);
+  check(same, "separate instances generate the same plane");
+
+  // connectivity: every cell of a 6x6-chunk window is reachable inside it
+  const int64_t lo = -3 * pitch, hi = 3 * pitch;
+  const int side = int(hi - lo + 1);
+  std::vector<char> seen(size_t(side) * side);
+  std::queue<std::pair<int64_t, int64_t>> queue;
+  queue.push({lo + 1, lo + 1});
+  seen[size_t(side) + 1] = 1;
+  while (!queue.empty()) {
+    const auto [x, y] = queue.front();
+    queue.pop();
+    const int steps[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    for (const auto &step : steps) {
+      const int64_t nx = x + step[0], ny = y + step[1];
+      if (nx <= lo || ny <= lo || nx >= hi || ny >= hi)
+        continue;
+      const size_t i = size_t(ny - lo) * side + (nx - lo);
+      if (!seen[i] && maze.at(nx, ny) == VISITED) {
+        seen[i] = 1;
+        queue.push({nx, ny});
+      }
+    }
+  }
+  int unreached = 0;
+  for (int64_t y = lo + 1; y < hi; y += 2)
+    for (int64_t x = lo + 1; x < hi; x += 2)
+      unreached += !seen[size_t(y - lo) * side + (x - lo)];
+  check(unreached == 0, std::to_string(unreached) + " cells unreachable");
+
+  // concurrent getChunk returns the requested chunks
+  std::vector<std::thread> threads;
+  std::vector<int> wrong(4);
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < 20000; i++) {
+        const auto chunk = maze.getChunk(i % 50 - t, i % 7);
+        wrong[t] += chunk->chunkX() != i % 50 - t || chunk->chunkY() != i % 7;
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+  check(wrong[0] + wrong[1] + wrong[2] + wrong[3] == 0,
+        "concurrent getChunk returns the requested chunks");
+  check(maze.cachedChunks() <= 16, "the cache stays within its capacity");
+
+  std::cout << "chunkedMaze: " << maze.misses() << " chunks generated, "
+            << failures << " failures\n";
+  return failures == 0 ? 0 : 1;
+}
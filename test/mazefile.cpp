@@ -0,0 +1,147 @@
+// Round-trips generated mazes through the .maze format: the header fields,
+// every pixel through MazeView::at() and the unpacked grid must match the
+// maze as generated, and damaged files must be rejected.
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "../include/generator.h"
+#include "../include/maze.h"
+#include "../include/mazefile.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string &what) {
+  if (!ok) {
+    std::cout << "FAIL: " << what << "\n";
+    failures++;
+  }
+}
+
+bool sameCells(const Grid &a, const Grid &b) {
+  if (a.width() != b.width() || a.height() != b.height())
+    return false;
+  for (size_t i = 0; i < a.size(); i++)
+    if (a[i] != b[i])
+      return false;
+  return true;
+}
+
+// true if opening the file throws std::runtime_error
+bool rejected(const std::string &filename) {
+  try {
+    MazeFile file(filename);
+  } catch (const std::runtime_error &) {
+    return true;
+  }
+  return false;
+}
+
+// true if opening the file throws std::runtime_error saying
+// "<filename>: not a maze file (...)."
+bool rejectedAsNotMaze(const std::string &filename) {
+  try {
+    MazeFile file(filename);
+  } catch (const std::runtime_error &error) {
+    return std::string(error.what()).starts_with(filename +
+                                                 ": not a maze file (");
+  }
+  return false;
+}
+
+// overwrites part of the file in place
+void patch(const std::string &filename, std::streamoff offset,
+           const std::string &bytes) {
+  std::fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+  file.seekp(offset);
+  file.write(bytes.data(), bytes.size());
+}
+
+} // namespace
+
+int main() {
+  const std::string filename =
+      (std::filesystem::temp_directory_path() / "maze-test.maze").string();
+
+  const int sizes[][2] = {{5, 5}, {7, 5}, {9, 13}, {101, 57}, {301, 301}};
+  const Algorithm algorithms[] = {Algorithm::BACKTRACKER, Algorithm::PRIM,
+                                  Algorithm::HUNT_AND_KILL,
+                                  Algorithm::UNIFORM};
+  int mazes = 0;
+  for (const auto &size : sizes) {
+    for (Algorithm algorithm : algorithms) {
+      const uint64_t seed = 1000 + mazes;
+      const std::string name = std::string(algorithmName(algorithm)) + " " +
+                               std::to_string(size[0]) + "x" +
+                               std::to_string(size[1]);
+
+      Grid grid(size[0], size[1]);
+      initializeMaze(grid);
+      MazeGenerator generator(algorithm);
+      generator.seed(seed);
+      generator.generate(grid, 2, 2);
+      writeMazeFile(filename, grid, seed, algorithm);
+
+      const MazeFile file(filename);
+      check(file.info().width == size[0] && file.info().height == size[1] &&
+                file.info().seed == seed && file.info().algorithm == algorithm,
+            name + ": header");
+
+      bool pixels = true;
+      for (int y = 0; y < size[1]; y++)
+        for (int x = 0; x < size[0]; x++)
+          pixels &= file.view().at(x, y) == grid.at(x, y);
+      check(pixels, name + ": MazeView::at");
+
+      Grid loaded;
+      file.view().toGrid(loaded);
+      check(sameCells(loaded, grid), name + ": toGrid");
+
+      // a solved grid stores the same walls
+      solveMaze(grid);
+      writeMazeFile(filename, grid, seed, algorithm);
+      Grid reloaded;
+      MazeFile(filename).view().toGrid(reloaded);
+      check(sameCells(reloaded, loaded), name + ": solved grid");
+      mazes++;
+    }
+  }
+
+  // damaged files, each reported as not a maze file
+  Grid grid(9, 9);
+  initializeMaze(grid);
+  MazeGenerator(Algorithm::BACKTRACKER).generate(grid, 2, 2);
+  writeMazeFile(filename, grid, 1, Algorithm::BACKTRACKER);
+  patch(filename, 32, std::string("nonesuch\0", 9));
+  check(rejectedAsNotMaze(filename), "an unknown algorithm is rejected");
+  writeMazeFile(filename, grid, 1, Algorithm::BACKTRACKER);
+  patch(filename, 16, std::string("\x08\0\0\0", 4));
+  check(rejectedAsNotMaze(filename), "an even width is rejected");
+  writeMazeFile(filename, grid, 1, Algorithm::BACKTRACKER);
+  patch(filename, 8, std::string("\x02\0\0\0", 4));
+  check(rejectedAsNotMaze(filename), "a later version is rejected");
+
+  writeMazeFile(filename, grid, 1, Algorithm::BACKTRACKER);
+  const auto size = std::filesystem::file_size(filename);
+  std::filesystem::resize_file(filename, size - 1);
+  check(rejectedAsNotMaze(filename), "truncated cell data is rejected");
+  patch(filename, 0, "MAZEGRIX");
+  check(rejectedAsNotMaze(filename), "a bad magic number is rejected");
+  std::filesystem::resize_file(filename, 32);
+  check(rejectedAsNotMaze(filename), "a file shorter than its header is "
+                                     "rejected");
+  std::filesystem::resize_file(filename, 0);
+  check(rejectedAsNotMaze(filename), "an empty file is rejected");
+  std::filesystem::remove(filename);
+  check(rejected(filename), "a missing file is rejected");
+
+  std::cout << "mazefile: " << mazes << " mazes round-tripped, " << failures
+            << " failures\n";
+  return failures == 0 ? 0 : 1;
+}
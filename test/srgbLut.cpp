@@ -0,0 +1,39 @@
+// Checks the sRGB lookup tables in Color_Space.h against the functions
+// they tabulate: every 8-bit code, and a sweep of linear values.
+
+#include <cmath>
+#include <iostream>
+
+#include "../include/Color_Space.h"
+
+int main() {
+  float linearError = 0;
+  int roundTripFailures = 0;
+  for (int code = 0; code < 256; code++) {
+    const float exact = clrspc::srgb_to_linear(code / 255.f);
+    linearError =
+        std::fmax(linearError, std::abs(clrspc::srgb8_to_linear(code) - exact));
+    if (clrspc::linear_to_srgb8(clrspc::srgb8_to_linear(code)) != code)
+      roundTripFailures++;
+  }
+
+  int encodeError = 0;
+  long differing = 0;
+  const int steps = 1 << 20;
+  for (int i = 0; i <= steps; i++) {
+    const float linear = float(i) / steps;
+    const int exact = std::lround(clrspc::linear_to_srgb(linear) * 255);
+    const int error = std::abs(clrspc::linear_to_srgb8(linear) - exact);
+    encodeError = std::max(encodeError, error);
+    differing += error != 0;
+  }
+
+  std::cout << "srgb8_to_linear: max error " << linearError
+            << " over 256 codes\n"
+            << "linear_to_srgb8: " << roundTripFailures
+            << " of 256 codes fail the round trip; max error " << encodeError
+            << " code, " << differing << " of " << steps + 1
+            << " linear values differ\n";
+
+  return linearError == 0 && roundTripFailures == 0 && encodeError <= 1 ? 0 : 1;
+}
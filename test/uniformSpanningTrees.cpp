@@ -0,0 +1,90 @@
+// Checks that the uniform generators sample every spanning tree of a small
+// maze equally often: a 3 x 2 cell maze has 15 spanning trees, and the
+// counts over many mazes must pass a chi-squared test against the uniform
+// distribution.
+
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+
+#include "../include/AldousBroderWilson.h"
+#include "../include/generator.h"
+#include "../include/maze.h"
+
+namespace {
+
+const int WIDTH = 9, HEIGHT = 7; // 3 x 2 cells
+const int TREES = 15;
+const int SAMPLES = 150000;
+// chi-squared with 14 degrees of freedom exceeds this with probability 0.001
+const double CRITICAL = 36.12;
+
+/**
+   Identifies a maze by the walls between its cells that are open.
+*/
+unsigned treeKey(const Grid &grid) {
+  unsigned key = 0, bit = 1;
+  for (int y = 2; y < HEIGHT - 2; y++) {
+    for (int x = 2; x < WIDTH - 2; x++, bit <<= 1) {
+      if ((x + y) % 2 == 1 && grid.at(x, y) == VISITED)
+        key |= bit;
+    }
+  }
+  return key;
+}
+
+/**
+   Generates SAMPLES mazes and returns the chi-squared statistic of their
+   tree counts, or -1 if they are not exactly the 15 spanning trees.
+*/
+template <class Generate> double chiSquared(Generate generate) {
+  std::map<unsigned, int> counts;
+  for (int i = 0; i < SAMPLES; i++) {
+    Grid grid(WIDTH, HEIGHT); // initializeMaze expects a fresh grid
+    initializeMaze(grid);
+    generate(grid);
+    counts[treeKey(grid)]++;
+  }
+  if (counts.size() != TREES)
+    return -1;
+  const double expected = double(SAMPLES) / TREES;
+  double chi2 = 0;
+  for (const auto &[key, count] : counts)
+    chi2 += (count - expected) * (count - expected) / expected;
+  return chi2;
+}
+
+int failures = 0;
+
+void check(const std::string &name, double chi2) {
+  const bool ok = chi2 >= 0 && chi2 < CRITICAL;
+  std::cout << name << ": chi-squared " << chi2 << (ok ? "" : " FAIL") << "\n";
+  failures += !ok;
+}
+
+} // namespace
+
+int main() {
+  MazeGenerator generator(Algorithm::UNIFORM);
+  generator.seed(1);
+  check("uniform", chiSquared([&](Grid &grid) {
+          generator.generate(grid, 2, 2);
+        }));
+
+  AldousBroderWilson<> wilson(std::mt19937(2), 0);
+  check("Wilson", chiSquared([&](Grid &grid) {
+          wilson.generate(grid, 2, 2);
+        }));
+
+  AldousBroderWilson<> aldousBroder(std::mt19937(3), 1);
+  check("Aldous-Broder", chiSquared([&](Grid &grid) {
+          aldousBroder.generate(grid, 2, 2);
+        }));
+
+  AldousBroderWilson<> hybrid(std::mt19937(4), 0.5);
+  std::cout << "hybrid at 0.5 (biased, not checked): chi-squared "
+            << chiSquared([&](Grid &grid) { hybrid.generate(grid, 2, 2); })
+            << "\n";
+  return failures == 0 ? 0 : 1;
+}